@@ -0,0 +1,48 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+/**
+ * Minimal timing harness for the parser microbenchmarks.
+ *
+ * Runs fn `iterations` times per round and prints the median time of one
+ * call over `rounds` rounds, which keeps a noisy first round or a context
+ * switch out of the figure. Results are folded into Bench::sink so the
+ * optimizer cannot drop the measured work.
+ *
+ * Example usage:
+ * @code
+ * Bench::run("split into spans", 10000, [&] {
+ *   return spans.size();
+ * });
+ * @endcode
+ */
+namespace Bench {
+  inline volatile size_t sink = 0;
+
+  template<typename F>
+  double run(const char* name, size_t iterations, F&& fn, int rounds = 9) {
+    std::vector<double> samples;
+    samples.reserve(rounds);
+
+    for (int round = 0; round < rounds; round++) {
+      auto start = std::chrono::steady_clock::now();
+      size_t acc = 0;
+      for (size_t i = 0; i < iterations; i++)
+        acc += static_cast<size_t>(fn());
+      auto elapsed = std::chrono::steady_clock::now() - start;
+
+      sink = sink + acc;
+      samples.push_back(std::chrono::duration<double, std::micro>(elapsed).count() / static_cast<double>(iterations));
+    }
+
+    std::sort(samples.begin(), samples.end());
+    double median = samples[samples.size() / 2];
+    std::printf("  %-34s %10.3f us\n", name, median);
+    return median;
+  }
+}
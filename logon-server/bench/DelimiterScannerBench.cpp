@@ -0,0 +1,115 @@
+#include <BaseApp.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <utils/DelimiterScanner.h>
+#include <SDK/Proton/TextScanner.h>
+
+#include "Bench.h"
+
+/**
+ * DelimiterScanner microbenchmark
+ * Splitting a large dialog_return, as sent by a dialog with a few hundred checkboxes.
+ *
+ * Covers the baseline std::string::find tokenizer, the span and copy split
+ * helpers, the raw "\n|" scan against find_first_of and the TextScanner
+ * setup, which splits lines and labels in one forEachAny("\n|") pass.
+ */
+
+namespace legacy {
+  // Utils::StringTokenize before DelimiterScanner
+  std::vector<std::string> tokenize(const std::string& text, const std::string& delim) {
+    std::vector<std::string> result;
+    if (text.empty())
+      return result;
+
+    size_t start = 0, end = 0;
+    while (end != std::string::npos) {
+      end = text.find(delim, start);
+      result.push_back(text.substr(start, (end == std::string::npos) ? std::string::npos : end - start));
+      start = ((end > (std::string::npos - delim.size())) ? std::string::npos : end + delim.size());
+    }
+    return result;
+  }
+}
+
+static std::string make_dialog_return(int checkboxes) {
+  std::string packet =
+    "action|dialog_return\n"
+    "dialog_name|merchant_servers\n"
+    "param|merchant=Gemtopia&page=3\n"
+    "buttonClicked|apply_changes\n"
+    "\n";
+  for (int i = 0; i < checkboxes; i++) {
+    packet += "checkbox_server_" + std::to_string(i) + "_maintenance|" + std::to_string(i % 2) + "\n";
+    packet += "text_server_" + std::to_string(i) + "_note|reachable from 10.0." + std::to_string(i % 256) + ".1 and mirrors\n";
+  }
+  return packet;
+}
+
+static const char* kernel_name(DelimiterScanner::Kernel kernel) {
+  switch (kernel) {
+    case DelimiterScanner::Kernel::AVX2: return "AVX2";
+    case DelimiterScanner::Kernel::SSE2: return "SSE2";
+    default: return "scalar";
+  }
+}
+
+int main() {
+  const std::string packet = make_dialog_return(200);
+  const std::string_view view(packet);
+  std::printf("dialog_return: %zu bytes, kernel %s\n", packet.size(), kernel_name(DelimiterScanner::activeKernel()));
+
+  std::printf("lines, then fields of every line\n");
+  Bench::run("baseline StringTokenize", 2000, [&] {
+    size_t total = 0;
+    for (const std::string& line : legacy::tokenize(packet, "\n"))
+      total += legacy::tokenize(line, "|").size();
+    return total;
+  });
+  Bench::run("splitCopy", 2000, [&] {
+    size_t total = 0;
+    for (const std::string& line : DelimiterScanner::splitCopy(view, "\n"))
+      total += DelimiterScanner::splitCopy(line, "|").size();
+    return total;
+  });
+  Bench::run("split into spans", 2000, [&] {
+    size_t total = 0;
+    DelimiterScanner::forEachSpan(view, "\n", [&](std::string_view line) {
+      DelimiterScanner::forEachSpan(line, "|", [&](std::string_view) { total++; });
+    });
+    return total;
+  });
+
+  std::printf("every '\\n' and '|' of the payload\n");
+  Bench::run("std::string_view::find_first_of", 2000, [&] {
+    size_t hits = 0;
+    for (size_t pos = view.find_first_of("\n|"); pos != std::string_view::npos; pos = view.find_first_of("\n|", pos + 1))
+      hits++;
+    return hits;
+  });
+  Bench::run("DelimiterScanner::findAny", 2000, [&] {
+    size_t hits = 0;
+    for (size_t pos = DelimiterScanner::findAny(view, "\n|"); pos != std::string_view::npos; pos = DelimiterScanner::findAny(view, "\n|", pos + 1))
+      hits++;
+    return hits;
+  });
+  Bench::run("DelimiterScanner::forEachAny", 2000, [&] {
+    size_t hits = 0;
+    DelimiterScanner::forEachAny(view, "\n|", [&](size_t) { hits++; return true; });
+    return hits;
+  });
+
+  std::printf("lines and their labels\n");
+  Bench::run("TextScanner::SetupFromView", 2000, [&] {
+    TextScanner scanner;
+    scanner.SetupFromView(view);
+    size_t total = 0;
+    for (int i = 0; i < scanner.GetLineCount(); i++)
+      total += scanner.GetLabelView(i).size();
+    return total;
+  });
+  return 0;
+}
@@ -0,0 +1,172 @@
+#include <BaseApp.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <SDK/Proton/TextScanner.h>
+
+#include "Bench.h"
+
+/**
+ * TextScanner microbenchmark
+ * Baseline line-by-line GetParmString against the indexed view scanner.
+ *
+ * Each case parses the packet and does the lookups its handler does:
+ * player_login on a login packet, join_server on a dialog_return.
+ * Before timing, view and copy setup must agree on the lines of every packet,
+ * CRLF and stray '\r' included.
+ */
+
+namespace legacy {
+  // TextScanner before the view and index changes: lines copied out, every lookup re-tokenizes each line
+  std::vector<std::string> tokenize(const std::string& text, const std::string& delim) {
+    std::vector<std::string> result;
+    if (text.empty())
+      return result;
+
+    size_t start = 0, end = 0;
+    while (end != std::string::npos) {
+      end = text.find(delim, start);
+      result.push_back(text.substr(start, (end == std::string::npos) ? std::string::npos : end - start));
+      start = ((end > (std::string::npos - delim.size())) ? std::string::npos : end + delim.size());
+    }
+    return result;
+  }
+
+  struct Scanner {
+    std::vector<std::string> lines;
+
+    explicit Scanner(const char* text) {
+      lines = tokenize(text, "\n");
+      for (std::string& line : lines) {
+        size_t pos;
+        while ((pos = line.find('\r')) != std::string::npos)
+          line.erase(pos, 1);
+      }
+    }
+
+    std::string GetParmString(const std::string& label, int index, const std::string& token = "|") {
+      for (const std::string& text : lines) {
+        if (text.empty())
+          continue;
+
+        std::vector<std::string> line = tokenize(text, token);
+        if (line.empty() || index < 0 || index >= static_cast<int>(line.size()))
+          continue;
+        if (line[0] == label)
+          return line[index];
+      }
+      return "";
+    }
+  };
+}
+
+static const char* LOGIN_PACKET =
+  "tankIDName|merchant_admin\n"
+  "tankIDPass|hunter2hunter2\n"
+  "requestedName|BraveCat\n"
+  "f|1\n"
+  "protocol|216\n"
+  "game_version|5.02\n"
+  "fz|22243512\n"
+  "cbits|1024\n"
+  "player_age|25\n"
+  "GDPR|2\n"
+  "FCMToken|\n"
+  "category|_-5100\n"
+  "totalPlaytime|0\n"
+  "klv|4f2a0ce7b5e94c3e8f9d1a6b7c2e0f3d\n"
+  "hash2|-1386428113\n"
+  "meta|ubistatic.com\n"
+  "fhash|-716928004\n"
+  "rid|02A1B6F1C4E95D2F0A3B7C8D9E0F1A2B\n"
+  "platformID|0,1,1\n"
+  "deviceVersion|0\n"
+  "country|id\n"
+  "hash|1783742315\n"
+  "mac|02:00:00:00:00:00\n"
+  "wk|A1B2C3D4E5F60718293A4B5C6D7E8F90\n"
+  "zf|-1576181843\n"
+  "UUIDToken|GT1AQAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA\n"
+  "doorID|Gemtopia\n";
+
+static const char* DIALOG_RETURN_PACKET =
+  "action|dialog_return\n"
+  "dialog_name|join_server\n"
+  "param|name=MY SERVER&host=127.0.0.1&port=17091\n"
+  "buttonClicked|save_server\n"
+  "\n"
+  "options_display_name|`2MY SERVER``\n"
+  "options_name|MY SERVER\n"
+  "options_host|127.0.0.1\n"
+  "options_port|17091\n"
+  "options_color|255,255,255\n"
+  "options_maintenance|0\n"
+  "options_hidden|0\n";
+
+static const char* LOGIN_LABELS[] = {
+  "tankIDName", "tankIDPass", "requestedName", "protocol", "game_version", "platformID",
+  "mac", "rid", "hash", "wk", "klv", "country", "UUIDToken", "doorID", "fz", "meta"
+};
+static const char* DIALOG_LABELS[] = {
+  "dialog_name", "param", "buttonClicked", "options_display_name", "options_name", "options_host",
+  "options_port", "options_color", "options_maintenance", "options_hidden", "action"
+};
+
+static const char* CRLF_PACKETS[] = {
+  "action|dialog_return\r\ndialog_name|join_server\r\nbuttonClicked|save_server\r\n",
+  "action|dialog_return\ndialog_name|join\r_server\noptions_name|MY\rSERVER\r\r\n\r",
+  "\r|label first\nrequestedName|Brave\rCat"
+};
+
+// SetupFromView against SetupFromMemoryAddress, which erases every '\r'
+static bool check_same_lines(const char* packet) {
+  TextScanner copied(packet);
+  TextScanner viewed;
+  viewed.SetupFromView(packet);
+
+  bool same = copied.GetLineCount() == viewed.GetLineCount();
+  for (int i = 0; same && i < copied.GetLineCount(); i++)
+    same = copied.GetLine(i) == viewed.GetLine(i) && copied.GetLabelView(i) == viewed.GetLabelView(i);
+  if (!same)
+    std::printf("view and copy setup disagree on %s\n", packet);
+  return same;
+}
+
+template<size_t N>
+static void compare(const char* title, const char* packet, const char* (&labels)[N]) {
+  std::printf("%s (%zu lookups)\n", title, N);
+
+  double before = Bench::run("baseline GetParmString", 20000, [&] {
+    legacy::Scanner scanner(packet);
+    size_t total = 0;
+    for (const char* label : labels)
+      total += scanner.GetParmString(label, 1).size();
+    return total;
+  });
+
+  std::string_view view(packet);
+  double after = Bench::run("indexed GetParmView", 20000, [&] {
+    TextScanner scanner;
+    scanner.SetupFromView(view);
+    size_t total = 0;
+    for (const char* label : labels)
+      total += scanner.GetParmView(label, 1).size();
+    return total;
+  });
+
+  std::printf("  speedup %.1fx\n\n", before / after);
+}
+
+int main() {
+  bool ok = check_same_lines(LOGIN_PACKET) && check_same_lines(DIALOG_RETURN_PACKET);
+  for (const char* packet : CRLF_PACKETS)
+    ok = check_same_lines(packet) && ok;
+  if (!ok)
+    return 1;
+
+  compare("login", LOGIN_PACKET, LOGIN_LABELS);
+  compare("dialog_return", DIALOG_RETURN_PACKET, DIALOG_LABELS);
+  return 0;
+}
@@ -2,6 +2,7 @@
 
 #include <SDK/Proton/MiscUtils.h>
 #include <SDK/Proton/FileSystem/FileManager.h>
+#include <utils/DelimiterScanner.h>
 #include <chrono>
 #include <array>
 #include <cassert>
@@ -15,38 +16,16 @@
 
 std::vector<std::string> Utils::StringTokenize(const std::string& text, const std::string& delim)
 {
-    std::vector<std::string> result;
     if (text.empty())
 	{
-		return result;
+		return {};
 	}
-
-    size_t start = 0, end = 0;
-    while (end != std::string::npos) 
-	{
-        end = text.find(delim, start);
-        result.push_back(text.substr(start, (end == std::string::npos) ? std::string::npos: end - start ));
-        start = ((end > (std::string::npos - delim.size())) ? std::string::npos :  end + delim.size());
-    }
-
-    return result;
+    return DelimiterScanner::splitCopy(text, delim);
 }
 
 std::vector<std::string> Utils::SplitString(const std::string& text, const std::string& delim)
 {
-    std::size_t startPos = 0, endPos, delimiterLength = delim.length();
-    std::string token{};
-    std::vector<std::string> ret{};
-
-    while ((endPos = text.find(delim, startPos)) != std::string::npos) 
-	{
-        token = text.substr(startPos, endPos - startPos);
-        startPos = endPos + delimiterLength;
-        ret.push_back(token);
-    }
-
-    ret.push_back(text.substr(startPos));
-    return ret;
+    return DelimiterScanner::splitCopy(text, delim);
 }
 
 bool Utils::SeparateString(const char str[], int num, char delim, char* pResult) 
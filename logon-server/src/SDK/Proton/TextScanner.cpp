@@ -3,6 +3,8 @@
 #include <SDK/Proton/TextScanner.h>
 #include <SDK/Proton/FileSystem/FileManager.h>
 #include <SDK/Proton/MiscUtils.h>
+#include <utils/DelimiterScanner.h>
+#include <algorithm>
 #pragma warning(disable : 4996)
 
 TextScanner::TextScanner() : m_lastLine(0) 
@@ -35,6 +37,7 @@ bool TextScanner::LoadFile(const std::string& fName)
 
 bool TextScanner::SetupFromMemoryAddress(const char* pCharArray)
 {
+	Kill();
 	m_lines = Utils::StringTokenize(pCharArray, "\n");
 	for (unsigned int i = 0; i < m_lines.size(); i++)
 	{
@@ -46,50 +49,317 @@ bool TextScanner::SetupFromMemoryAddress(const char* pCharArray)
 
 bool TextScanner::SetupFromMemoryAddressRaw(const char* pCharArray, int size)
 {
+	Kill();
 	m_lines = Utils::StringTokenize(pCharArray, "\n");
 	return true;
 }
 
-std::string TextScanner::GetParmString(std::string label, int index, std::string token)
+bool TextScanner::SetupFromView(std::string_view text)
 {
-	if (m_lines.empty())
+	Kill();
+	m_bViewMode = true;
+	if (text.empty())
 	{
-		return "";
+		return true;
 	}
 
-	for (unsigned int i = 0; i < m_lines.size(); i++) 
+	//Same split as StringTokenize(text, "\n"), trailing '\r' is cut instead of erased from the buffer.
+	//One "\n|\r" pass finds the line ends and the first '|' of each line, so labels come out of the split for free.
+	//A '\r' anywhere else cannot be cut from a view, such text is copied out like SetupFromMemoryAddress does
+	size_t start = 0, label = std::string_view::npos;
+	bool strayCR = false;
+	auto addLine = [&](size_t end)
 	{
-		if (m_lines[i].empty()) 
+		std::string_view line = text.substr(start, end - start);
+		if (!line.empty() && line.back() == '\r')
 		{
-			continue;
+			line.remove_suffix(1);
+		}
+		uint16_t labelLength = label < C_NO_LABEL ? (uint16_t)label : C_NO_LABEL;
+
+		if (m_viewLineCount < C_INLINE_VIEW_LINES)
+		{
+			m_inlineViews[m_viewLineCount] = line;
+			m_inlineLabels[m_viewLineCount] = labelLength;
+		}
+		else
+		{
+			m_extraViews.push_back(line);
+			m_extraLabels.push_back(labelLength);
+		}
+		m_viewLineCount++;
+	};
+
+	DelimiterScanner::forEachAny(text, "\n|\r", [&](size_t pos)
+	{
+		if (text[pos] == '\r')
+		{
+			if (pos + 1 < text.size() && text[pos + 1] != '\n')
+			{
+				strayCR = true;
+			}
+			return true;
+		}
+		if (text[pos] == '|')
+		{
+			if (label == std::string_view::npos)
+			{
+				label = pos - start;
+			}
+			return true;
+		}
+
+		addLine(pos);
+		start = pos + 1;
+		label = std::string_view::npos;
+		return true;
+	});
+	addLine(text.size());
+
+	if (strayCR)
+	{
+		Materialize();
+		for (unsigned int i = 0; i < m_lines.size(); i++)
+		{
+			Utils::StringReplace("\r", "", m_lines[i]);
+		}
+	}
+	return true;
+}
+
+std::string_view TextScanner::LineAt(int lineNum) const
+{
+	if (!m_bViewMode)
+	{
+		return m_lines[lineNum];
+	}
+	return lineNum < C_INLINE_VIEW_LINES ? m_inlineViews[lineNum] : m_extraViews[lineNum - C_INLINE_VIEW_LINES];
+}
+
+std::string_view TextScanner::LabelAt(int lineNum) const
+{
+	std::string_view line = LineAt(lineNum);
+	if (m_bViewMode)
+	{
+		uint16_t length = lineNum < C_INLINE_VIEW_LINES ? m_inlineLabels[lineNum] : m_extraLabels[lineNum - C_INLINE_VIEW_LINES];
+		if (length != C_NO_LABEL)
+		{
+			return line.substr(0, length);
+		}
+	}
+
+	//No '|' seen while splitting, or the lines were copied out: the whole line or up to its first '|'
+	return line.substr(0, DelimiterScanner::find(line, '|'));
+}
+
+void TextScanner::Materialize()
+{
+	if (!m_bViewMode)
+	{
+		return;
+	}
+
+	std::vector<std::string> lines;
+	lines.reserve(m_viewLineCount);
+	for (int i = 0; i < m_viewLineCount; i++)
+	{
+		lines.emplace_back(LineAt(i));
+	}
+
+	int lastLine = m_lastLine;
+	Kill();
+	m_lines = std::move(lines);
+	m_lastLine = lastLine;
+}
+
+bool TextScanner::GetField(std::string_view line, int index, std::string_view token, std::string_view& field)
+{
+	if (index < 0 || token.empty())
+	{
+		return false;
+	}
+
+	size_t start = 0;
+	for (int i = 0; i < index; i++)
+	{
+		size_t end = DelimiterScanner::find(line, token, start);
+		if (end == std::string_view::npos)
+		{
+			return false;
 		}
+		start = end + token.size();
+	}
+
+	size_t end = DelimiterScanner::find(line, token, start);
+	field = line.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+	return true;
+}
+
+static uint32_t HashLabel(std::string_view label)
+{
+	//FNV-1a
+	uint32_t hash = 2166136261u;
+	for (char c : label)
+	{
+		hash = (hash ^ (uint8_t)c) * 16777619u;
+	}
+	return hash;
+}
+
+void TextScanner::BuildIndex()
+{
+	m_bIndexBuilt = true;
+	m_bHasIndex = false;
+
+	int lineCount = GetLineCount();
+	if (lineCount == 0 || lineCount >= 0xFFFF)
+	{
+		return; //Nothing to index, or line numbers do not fit a slot
+	}
+
+	//Keep the load factor at or under 0.5
+	uint32_t slots = C_INLINE_INDEX_SLOTS;
+	while (slots < (uint32_t)lineCount * 2)
+	{
+		slots <<= 1;
+	}
+
+	m_bExtraIndex = slots != C_INLINE_INDEX_SLOTS;
+	if (m_bExtraIndex)
+	{
+		m_extraIndex.assign(slots, 0);
+	}
+	else
+	{
+		std::fill(m_inlineIndex, m_inlineIndex + C_INLINE_INDEX_SLOTS, 0);
+	}
+	m_bHasIndex = true;
+	m_indexMask = slots - 1;
+	uint16_t* index = IndexSlots();
 
-		std::vector<std::string> line = Utils::StringTokenize(m_lines[i], token);
-		if (line.empty() || index < 0 || index > line.size())
+	for (int i = 0; i < lineCount; i++)
+	{
+		if (LineAt(i).empty())
 		{
 			continue;
 		}
+		std::string_view key = LabelAt(i);
+
+		uint32_t slot = HashLabel(key) & m_indexMask;
+		while (index[slot] != 0)
+		{
+			if (LabelAt(index[slot] - 1) == key)
+			{
+				break; //Lookups start at the first line with this label
+			}
+			slot = (slot + 1) & m_indexMask;
+		}
+		if (index[slot] == 0)
+		{
+			index[slot] = (uint16_t)(i + 1);
+		}
+	}
+}
+
+int TextScanner::FindIndexedLine(std::string_view label)
+{
+	if (!m_bIndexBuilt)
+	{
+		BuildIndex();
+	}
+	if (!m_bHasIndex)
+	{
+		return -2; //No index, caller scans
+	}
+	uint16_t* index = IndexSlots();
+
+	uint32_t slot = HashLabel(label) & m_indexMask;
+	while (index[slot] != 0)
+	{
+		int line = index[slot] - 1;
+		if (LabelAt(line) == label)
+		{
+			return line;
+		}
+		slot = (slot + 1) & m_indexMask;
+	}
+	return -1;
+}
+
+std::vector<std::string> TextScanner::GetLines() const
+{
+	if (!m_bViewMode)
+	{
+		return m_lines;
+	}
+
+	std::vector<std::string> lines;
+	lines.reserve(m_viewLineCount);
+	for (int i = 0; i < m_viewLineCount; i++)
+	{
+		lines.emplace_back(LineAt(i));
+	}
+	return lines;
+}
+
+std::string TextScanner::GetParmString(std::string_view label, int index, std::string_view token)
+{
+	return std::string(GetParmView(label, index, token));
+}
+
+std::string_view TextScanner::GetParmView(std::string_view label, int index, std::string_view token)
+{
+	int first = 0;
+	if (token == "|")
+	{
+		first = FindIndexedLine(label);
+		if (first == -1)
+		{
+			return "";
+		}
+
+		std::string_view value;
+		if (first >= 0 && GetField(LineAt(first), index, token, value))
+		{
+			return value;
+		}
+		//Index unavailable, or the first line lacks that field: scan the rest like before
+		first = first < 0 ? 0 : first + 1;
+	}
 
-		if (line[0] == label)
+	for (int i = first; i < GetLineCount(); i++)
+	{
+		std::string_view line = LineAt(i);
+		if (line.empty())
 		{
-			return line[index];
+			continue;
 		}
 
+		std::string_view key, value;
+		if (!GetField(line, 0, token, key) || key != label)
+		{
+			continue;
+		}
+		if (GetField(line, index, token, value))
+		{
+			return value;
+		}
 	}
 
 	return "";
 }
-int TextScanner::GetParmInt(std::string label, int index, std::string token) 
+
+int TextScanner::GetParmInt(std::string_view label, int index, std::string_view token)
 {
 	return std::atoi(GetParmString(label, index, token).c_str());
 }
 
-uint32_t TextScanner::GetParmUInt(std::string label, int index, std::string token) 
+uint32_t TextScanner::GetParmUInt(std::string_view label, int index, std::string_view token)
 {
 	return (uint32_t)std::atoi(GetParmString(label, index, token).c_str());
 }
 
-float TextScanner::GetParmFloat(std::string label, int index, std::string token) 
+float TextScanner::GetParmFloat(std::string_view label, int index, std::string_view token)
 {
 	return (float)std::atof(GetParmString(label, index, token).c_str());
 }
@@ -103,22 +373,30 @@ void TextScanner::Kill()
 {
 	m_lines.clear();
 	m_lastLine = 0;
+	m_bViewMode = false;
+	m_viewLineCount = 0;
+	m_extraViews.clear();
+	m_extraLabels.clear();
+	m_bIndexBuilt = false;
+	m_bHasIndex = false;
+	m_extraIndex.clear();
 }
 
-std::string TextScanner::GetMultipleLineStrings(std::string label,std::string token)
+std::string TextScanner::GetMultipleLineStrings(std::string_view label, std::string_view token)
 {
-	for (unsigned int i=m_lastLine; i < m_lines.size(); i++) 
+	for (int i = m_lastLine; i < GetLineCount(); i++)
 	{
-		if (m_lines[i].empty()) 
+		std::string_view line = LineAt(i);
+		if (line.empty())
 		{
 			continue;
 		}
 
-		std::vector<std::string> line = Utils::StringTokenize(m_lines[i], token);
-		if (line[0] == label) 
+		std::string_view key;
+		if (GetField(line, 0, token, key) && key == label)
 		{
 			m_lastLine = i+1;
-			return m_lines[i];
+			return std::string(line);
 		}
 	}
 
@@ -128,64 +406,70 @@ std::string TextScanner::GetMultipleLineStrings(std::string label,std::string to
 
 std::string TextScanner::GetLine(int lineNum)
 {
-	return ((int)m_lines.size() > lineNum && lineNum >= 0) ? m_lines[lineNum] : "";
+	return (GetLineCount() > lineNum && lineNum >= 0) ? std::string(LineAt(lineNum)) : "";
+}
+
+std::string_view TextScanner::GetLineView(int lineNum) const
+{
+	return (GetLineCount() > lineNum && lineNum >= 0) ? LineAt(lineNum) : std::string_view();
+}
+
+std::string_view TextScanner::GetLabelView(int lineNum) const
+{
+	return (GetLineCount() > lineNum && lineNum >= 0) ? LabelAt(lineNum) : std::string_view();
 }
 
 std::string TextScanner::GetAllRaw()
 {
 	std::string s;
-	for (unsigned int i = 0; i < m_lines.size(); i++)
+	for (int i = 0; i < GetLineCount(); i++)
 	{
-		s += m_lines[i] + "\n";
+		s += LineAt(i);
+		s += "\n";
 	}
 
 	return s;
 }
 
-std::string TextScanner::GetParmStringFromLine(int lineNum, int index, std::string token)
+std::string TextScanner::GetParmStringFromLine(int lineNum, int index, std::string_view token)
 {
-	if (!(lineNum >= 0 && (uint32_t)lineNum < m_lines.size())) 
-	{
-		return "";
-	}
-	if (token.size() != 1)
-	{
-		return "";
-	}
-
-	return Utils::SeparateStringSTL(m_lines[lineNum], index, token[0]);
+	return std::string(GetParmViewFromLine(lineNum, index, token));
 }
 
-int TextScanner::GetParmIntFromLine(int lineNum, int index,std::string token /*= "|"*/)
+std::string_view TextScanner::GetParmViewFromLine(int lineNum, int index, std::string_view token)
 {
-	if (!(lineNum >= 0 && (uint32_t)lineNum < m_lines.size())) 
+	if (!(lineNum >= 0 && lineNum < GetLineCount()))
 	{
-		return 0;
+		return {};
 	}
 	if (token.size() != 1)
 	{
-		return 0;
+		return {};
 	}
 
-	return std::atoi(Utils::SeparateStringSTL(m_lines[lineNum], index, token[0]).c_str());
+	//SeparateStringSTL limit
+	std::string_view line = LineAt(lineNum), field;
+	if (line.size() > 4048 || !GetField(line, index, token, field))
+	{
+		return {};
+	}
+	return field;
 }
 
-float TextScanner::GetParmFloatFromLine(int lineNum, int index,std::string token /*= "|"*/)
+int TextScanner::GetParmIntFromLine(int lineNum, int index, std::string_view token /*= "|"*/)
 {
-	if (!(lineNum >= 0 && (uint32_t)lineNum < m_lines.size())) 
-	{
-		return 0.f;
-	}
-	if (token.size() != 1)
-	{
-		return 0.f;
-	}
+	return std::atoi(GetParmStringFromLine(lineNum, index, token).c_str());
+}
 
-	return (float)std::atof(Utils::SeparateStringSTL(m_lines[lineNum], index, token[0]).c_str());
+float TextScanner::GetParmFloatFromLine(int lineNum, int index, std::string_view token /*= "|"*/)
+{
+	return (float)std::atof(GetParmStringFromLine(lineNum, index, token).c_str());
 }
 
 void TextScanner::Replace(const std::string& thisStr, const std::string& thatStr)
 {
+	Materialize();
+	m_bIndexBuilt = false;
 	for (unsigned int i = 0; i < m_lines.size(); i++)
 	{
 		Utils::StringReplace(thisStr, thatStr, m_lines[i]);
@@ -196,7 +480,7 @@ void TextScanner::DumpToLog()
 {
 	for (int i = 0; i < GetLineCount(); i++) 
 	{
-		std::string tmp = m_lines[i].c_str();
+		std::string tmp(LineAt(i));
 	    Utils::StringReplace("%", "%%", tmp);
 	}
 }
@@ -212,9 +496,10 @@ bool TextScanner::SaveFile(const std::string& fName /*= true*/)
 		return false;
 	}
 
-	for (uint32_t i = 0; i < m_lines.size(); i++) 
+	for (int i = 0; i < GetLineCount(); i++)
 	{
-		fwrite(m_lines[i].c_str(), m_lines[i].size(), 1, fp);
+		std::string_view line = LineAt(i);
+		fwrite(line.data(), line.size(), 1, fp);
 		fwrite(lineFeed.c_str(), lineFeed.size(), 1, fp);
 	}
 	
@@ -224,6 +509,8 @@ bool TextScanner::SaveFile(const std::string& fName /*= true*/)
 
 void TextScanner::DeleteLine(int lineNum)
 {
+	Materialize();
+	m_bIndexBuilt = false;
 	if (m_lastLine && m_lastLine >= lineNum) 
 	{
 		m_lastLine--;
@@ -234,12 +521,12 @@ void TextScanner::DeleteLine(int lineNum)
 
 std::vector<std::string> TextScanner::TokenizeLine(int lineNum, const std::string& theDelimiter /*= "|"*/)
 {
-	return Utils::StringTokenize(m_lines[lineNum], theDelimiter);
+	return Utils::StringTokenize(std::string(LineAt(lineNum)), theDelimiter);
 }
 
 void TextScanner::AppendToFile(std::string fileName /*= true*/)
 {
-	if (m_lines.empty()) 
+	if (GetLineCount() == 0)
 	{
 		return;
 	}
@@ -260,9 +547,9 @@ void TextScanner::AppendToFile(std::string fileName /*= true*/)
 	}
 
 	std::string temp;
-	for (uint32_t i = 0; i < m_lines.size(); i++) 
+	for (int i = 0; i < GetLineCount(); i++)
 	{
-		temp = m_lines[i]+"\r\n";
+		temp = std::string(LineAt(i)) + "\r\n";
 		fwrite(temp.c_str(), temp.size(), 1, fp);
 	}
 
@@ -271,6 +558,8 @@ void TextScanner::AppendToFile(std::string fileName /*= true*/)
 
 bool TextScanner::AppendFromMemoryAddress(const char* pCharArray)
 {
+	Materialize();
+	m_bIndexBuilt = false;
 	std::vector<std::string> tempVec = Utils::StringTokenize(pCharArray, "\n");
 	for (unsigned int i = 0; i < tempVec.size(); i++) 
 	{
@@ -283,6 +572,8 @@ bool TextScanner::AppendFromMemoryAddress(const char* pCharArray)
 
 bool TextScanner::AppendFromString(const std::string lines)
 {
+	Materialize();
+	m_bIndexBuilt = false;
 	std::vector<std::string> tempVec= Utils::StringTokenize(lines, "\n");
 	for (unsigned int i = 0; i < tempVec.size(); i++) 
 	{
@@ -295,6 +586,8 @@ bool TextScanner::AppendFromString(const std::string lines)
 
 bool TextScanner::AppendFromMemoryAddressRaw(const char* pCharArray, int size)
 {
+	Materialize();
+	m_bIndexBuilt = false;
 	std::vector<std::string> tempVec= Utils::StringTokenize(pCharArray, "\n");
 	for (unsigned int i = 0; i < tempVec.size(); i++)
 	{
@@ -1,9 +1,10 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <string_view>
 #include <SDK/Proton/Math.h>
 
-class TextScanner 
+class TextScanner
 {
 public:
 	TextScanner();
@@ -15,23 +16,30 @@ public:
 
 	bool LoadFile(const std::string& fName);
 	bool SaveFile(const std::string& fName);
-	std::string GetParmString(std::string label, int index, std::string token = "|");
-	uint32_t GetParmUInt(std::string label, int index, std::string token = "|");
-	int GetParmInt(std::string label, int index, std::string token = "|");
-	float GetParmFloat(std::string label, int index, std::string token = "|");
-	std::string GetParmStringFromLine(int lineNum, int index, std::string token = "|");
-	int GetParmIntFromLine(int lineNum, int index, std::string token = "|");
-	float GetParmFloatFromLine(int lineNum, int index, std::string token = "|");
-	std::string GetMultipleLineStrings(std::string label, std::string token = "|");
+	std::string GetParmString(std::string_view label, int index, std::string_view token = "|");
+	std::string_view GetParmView(std::string_view label, int index, std::string_view token = "|");
+	uint32_t GetParmUInt(std::string_view label, int index, std::string_view token = "|");
+	int GetParmInt(std::string_view label, int index, std::string_view token = "|");
+	float GetParmFloat(std::string_view label, int index, std::string_view token = "|");
+	std::string GetParmStringFromLine(int lineNum, int index, std::string_view token = "|");
+	std::string_view GetParmViewFromLine(int lineNum, int index, std::string_view token = "|");
+	int GetParmIntFromLine(int lineNum, int index, std::string_view token = "|");
+	float GetParmFloatFromLine(int lineNum, int index, std::string_view token = "|");
+	std::string GetMultipleLineStrings(std::string_view label, std::string_view token = "|");
 	std::string GetLine(int lineNum); //0 based, returns "" if out of range
+	std::string_view GetLineView(int lineNum) const; //Same as GetLine without the copy, valid until the lines are modified
+	std::string_view GetLabelView(int lineNum) const; //Text of the line before its first '|', the whole line if it has none
 	void Replace(const std::string& thisStr, const std::string& thatStr);
-	bool IsLoaded() { return !m_lines.empty(); }
+	bool IsLoaded() { return GetLineCount() != 0; }
 	bool SetupFromMemoryAddress(const char* pCharArray);
 	bool SetupFromMemoryAddressRaw(const char* pCharArray, int size);
+	//Lines point into text, which must outlive the scanner. Nothing is copied until a method modifies the lines
+	bool SetupFromView(std::string_view text);
+	bool IsView() const { return m_bViewMode; }
 	void DeleteLine(int lineNum);
 	std::string GetAllRaw();
-	std::vector<std::string> GetLines() const { return m_lines; }
-	int GetLineCount() { return (int)m_lines.size(); }
+	std::vector<std::string> GetLines() const;
+	int GetLineCount() const { return m_bViewMode ? m_viewLineCount : (int)m_lines.size(); }
 	void DumpToLog();
 	std::vector<std::string> TokenizeLine(int lineNum, const std::string& theDelimiter = "|");
 	void AppendToFile(std::string fileName);
@@ -40,13 +48,42 @@ public:
 	bool AppendFromString(const std::string lines);
 
 public:
-    bool Contain(const std::string& key, int index = 1, const std::string& token = "|", int key_index = 0) 
+    bool Contain(std::string_view key, int index = 1, std::string_view token = "|", int key_index = 0)
 	{
-        return GetParmString(key, index, token) != "" ? true : false;
+        return !GetParmView(key, index, token).empty();
     }
-    
+
 private:
+	std::string_view LineAt(int lineNum) const;
+	std::string_view LabelAt(int lineNum) const;
+	void Materialize();
+	static bool GetField(std::string_view line, int index, std::string_view token, std::string_view& field);
+	void BuildIndex();
+	int FindIndexedLine(std::string_view label);
+	uint16_t* IndexSlots() { return m_bExtraIndex ? m_extraIndex.data() : m_inlineIndex; }
+
 	int m_lastLine;
 	std::vector<std::string> m_lines;
 
-};
\ No newline at end of file
+	//View mode, typical packets fit in the inline array so parsing them does not allocate
+	static const int C_INLINE_VIEW_LINES = 64;
+	bool m_bViewMode = false;
+	int m_viewLineCount = 0;
+	std::string_view m_inlineViews[C_INLINE_VIEW_LINES];
+	std::vector<std::string_view> m_extraViews;
+	//Length of the text before the first '|' of each view line, found while splitting. C_NO_LABEL when the line has none
+	static const uint16_t C_NO_LABEL = 0xFFFF;
+	uint16_t m_inlineLabels[C_INLINE_VIEW_LINES];
+	std::vector<uint16_t> m_extraLabels;
+
+	//Label -> first line index for the default "|" token, open addressing, built on the first lookup.
+	//Slots hold line + 1, 0 is empty. Packets with more lines than fit in the inline table use m_extraIndex
+	static const int C_INLINE_INDEX_SLOTS = 128;
+	bool m_bIndexBuilt = false;
+	bool m_bHasIndex = false;
+	bool m_bExtraIndex = false;
+	uint32_t m_indexMask = 0;
+	uint16_t m_inlineIndex[C_INLINE_INDEX_SLOTS];
+	std::vector<uint16_t> m_extraIndex;
+
+};
@@ -4,10 +4,26 @@
 #include "server/handler/NetMessageGenericText.h"
 #include "server/handler/NetMessageGameMessage.h"
 #include "server/DataManager.h"
+#include "server/HandlerPool.h"
+#include "server/MerchantCatalog.h"
+#include "server/WriteBehind.h"
+#include "server/Database.h"
+#include "server/SessionStore.h"
+#include "server/RegistrationIndex.h"
+#include "server/GatewayStats.h"
 
 #include "utils/ConsoleInterface.h"
 
-int main(int, char**){
+#include <csignal>
+
+// Server yang sedang jalan, dipakai signal handler untuk shutdown yang bersih
+static ENetServer* running_server = nullptr;
+static void on_shutdown_signal(int) {
+  if (running_server)
+    running_server->stop();
+}
+
+int main(int argc, char** argv){
   enet_initialize();
 
   // Intro cenutttt
@@ -29,22 +45,76 @@ int main(int, char**){
   });
   print_info("Loaded {} NetMessageGameMessage handler.", temp_val);
 
+  // Semua state database ada di store, layout JSON cuma untuk import/export
+  const auto& config = DataManager::get_server_config();
+  if (!Database::open(config.store_dir, "../../../database/")) {
+    print_error("Failed to open the store at {}", config.store_dir);
+    enet_deinitialize();
+    return 1;
+  }
+  Database::get_store().setCompactThreshold(static_cast<uint64_t>(config.store_compact_kb) * 1024);
+  if (argc > 1 && std::string(argv[1]) == "--export-json") {
+    print_info("Exported {} files to the JSON layout.", Database::export_json("../../../database/"));
+    Database::close();
+    enet_deinitialize();
+    return 0;
+  }
+
+  GatewayStats::load();
+  temp_val = static_cast<int>(RegistrationIndex::load());
+  print_info("Loaded registrations of {} addresses.", temp_val);
+  temp_val = static_cast<int>(SessionStore::load(std::chrono::hours(24 * config.session_ttl_days)));
+  print_info("Restored {} sessions.", temp_val);
+
+  temp_val = 0;
+  ConsoleInterface::show_loading("Loading merchant catalog...", [&] {
+    temp_val = static_cast<int>(MerchantCatalog::load());
+  });
+  print_info("Loaded {} merchants.", temp_val);
+
+  // Hasil check-ip dari sesi sebelumnya, supaya restart tidak mulai dari cache kosong
+  DataManager::load_cache_snapshot();
+
+  // Handler yang lambat (file I/O) tidak boleh menahan ENet service thread
+  HandlerPool::start(config.handler_workers);
+  // Store sudah jadi sumber utama, flusher cuma perlu jalan kalau perubahan juga di-mirror ke layout JSON
+  if (config.json_export) {
+    MerchantCatalog::set_json_mirror(true);
+    WriteBehind::start(std::chrono::milliseconds(config.write_behind_ms));
+  }
+
   ENetAddress address;
   std::string ip = "0.0.0.0";
   enet_address_set_host(&address, ip.c_str());
   address.port = 17090;
 
   try {
-    ENetServer app(address);
+    ENetServer app(address, config.enet_shards);
     app.set_max_incoming_bandwidth(5000);
     app.set_max_outgoing_bandwidth(5000);
     app.set_max_peer(500);
+    app.set_snapshot_interval(std::chrono::seconds(config.snapshot_interval));
+
+    running_server = &app;
+    std::signal(SIGINT, on_shutdown_signal);
+    std::signal(SIGTERM, on_shutdown_signal);
+
     app.service()->join();
+    running_server = nullptr;
+    // Handler yang masih jalan harus selesai sebelum peer dan host ENet dihapus
+    app.shutdown();
   }
   catch (const std::runtime_error& e) {
+    running_server = nullptr;
     print_error("{}", e.what());
   }
 
+  // Simpan cache terakhir sebelum keluar, dimuat lagi saat start berikutnya
+  DataManager::save_cache_snapshot();
+  // Sudah dihentikan oleh ENetServer::shutdown, kecuali server gagal dibuat
+  HandlerPool::stop();
+  WriteBehind::stop();
+  Database::close();
   enet_deinitialize();
   return 0;
 }
@@ -0,0 +1,49 @@
+#include "ConstPacket.h"
+
+#include <stdexcept>
+
+#include "PacketVariant.h"
+
+ConstPacketSet::ConstPacketSet() {
+  for (size_t i = 0; i < m_packets.size(); i++) {
+    ENetPacket* packet = build(static_cast<ConstPacketId>(i));
+    if (packet == nullptr)
+      throw std::runtime_error("Failed to allocate constant packets.");
+
+    // Reference of the set, released in the destructor
+    packet->referenceCount = 1;
+    m_packets[i] = packet;
+  }
+}
+ConstPacketSet::~ConstPacketSet() {
+  for (ENetPacket* packet : m_packets) {
+    // Peers still holding it free it with their last reference
+    if (packet != nullptr && --packet->referenceCount == 0)
+      enet_packet_destroy(packet);
+  }
+}
+ENetPacket* ConstPacketSet::build(ConstPacketId id) {
+  switch (id) {
+    case ConstPacketId::HELLO: {
+      ENetPacket* packet = enet_packet_create(nullptr, 5, ENET_PACKET_FLAG_RELIABLE);
+      if (packet != nullptr) {
+        int type = 1;
+        memcpy(packet->data, &type, 4);
+        packet->data[4] = 0;
+      }
+      return packet;
+    }
+    case ConstPacketId::VALIDATING_REQUEST:
+      return make_variant_packet("OnConsoleMessage", "`oValidating request...");
+    case ConstPacketId::ADDRESS_BLOCKED:
+      return make_variant_packet("OnConsoleMessage", "`o`4Oops``: It appears you're using a `4prohibited third-party application`` or logging in with a `4prohibited address``. If this is a false alert, please contact the `0merchant owner`` or try login again.");
+    case ConstPacketId::ADDRESS_WARNED:
+      return make_variant_packet("OnConsoleMessage", "`o`6Warning``: It appears you're using a `4prohibited third-party application`` or logging in with a `4prohibited address``.");
+    case ConstPacketId::THIRD_PARTY_WARNING:
+      return make_variant_packet("OnConsoleMessage", "`9Warning: Our system has detected that you're using a `4third-party application`9. Some servers may deny your access. If you believe this is a mistake, please contact the `omerchant owner`9.");
+    case ConstPacketId::FAILED_TO_ENTER_WORLD:
+      return make_variant_packet("OnFailedToEnterWorld");
+    default:
+      return nullptr;
+  }
+}
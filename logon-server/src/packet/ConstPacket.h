@@ -0,0 +1,52 @@
+#pragma once
+
+#include <BaseApp.h>
+
+#include <array>
+
+#include <enet/enet.h>
+
+/**
+ * Packets that are byte-for-byte the same for every player
+ */
+enum class ConstPacketId : enet_uint8 {
+  HELLO,                    /** <- NET_MESSAGE_SERVER_HELLO, starts the login */
+  VALIDATING_REQUEST,
+  ADDRESS_BLOCKED,
+  ADDRESS_WARNED,
+  THIRD_PARTY_WARNING,
+  FAILED_TO_ENTER_WORLD,
+  COUNT
+};
+
+/**
+ * ConstPacketSet
+ * Every ConstPacketId encoded once, sent to any number of peers without
+ * allocating or serializing again.
+ *
+ * The set keeps its own reference on each packet, so ENet never frees them:
+ * enet_peer_send adds a reference per peer and drops it once the packet was
+ * acknowledged. referenceCount is a plain counter, so every shard owns a set
+ * and only its thread sends from it.
+ *
+ * Example usage:
+ * @code
+ * pClient->get_handle().send(ConstPacketId::HELLO);  // Any thread, resolved by the shard
+ * enet_peer_send(peer, 0, shard->constants.get(ConstPacketId::HELLO)); // Shard thread
+ * @endcode
+ */
+class ConstPacketSet {
+  public:
+  ConstPacketSet();
+  ~ConstPacketSet();
+
+  ConstPacketSet(const ConstPacketSet&) = delete;
+  ConstPacketSet& operator=(const ConstPacketSet&) = delete;
+
+  ENetPacket* get(ConstPacketId id) const { return m_packets[static_cast<size_t>(id)]; }
+
+  private:
+  std::array<ENetPacket*, static_cast<size_t>(ConstPacketId::COUNT)> m_packets{};
+
+  static ENetPacket* build(ConstPacketId id);
+};
@@ -100,5 +100,5 @@ void PacketVariant::CreatePacket ( ENetPeer* peer ) {
   if (!Utils::PeerValidation(peer)) return;
 
   ENetPacket* packet = enet_packet_create ( packet_data , len , 1 );
-  enet_peer_send ( peer , 0 , packet );
+  pClient->get_handle ( ).send ( packet );
 }
\ No newline at end of file
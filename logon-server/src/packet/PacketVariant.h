@@ -2,10 +2,15 @@
 
 #include <BaseApp.h>
 
+#include <array>
+#include <cstring>
 #include <string>
+#include <string_view>
+#include <type_traits>
 
 #include <enet/enet.h>
 
+#include <SDK/Proton/Math.h>
 #include <utils/Utils.h>
 
 struct PacketVariant
@@ -24,4 +29,147 @@ public:
 	PacketVariant* Insert ( float a , float b );
 	PacketVariant* Insert ( float a , float b , float c );
 	void CreatePacket ( ENetPeer* peer );
-};
\ No newline at end of file
+};
+
+struct VariantOptions
+{
+	int delay = 0;
+	int NetID = -1;
+};
+
+/**
+ * Several strings sent as one string variant, without joining them first.
+ * The parts are views, build it inside the make_variant_packet call
+ */
+template<size_t N>
+struct VariantConcat
+{
+	std::array<std::string_view, N> parts;
+};
+
+template<typename... Parts>
+VariantConcat<sizeof...(Parts)> variant_concat ( const Parts&... parts )
+{
+	return { { std::string_view ( parts )... } };
+}
+
+/**
+ * Size and wire format of every variant type, same layout as PacketVariant::Insert
+ */
+struct VariantEncoder
+{
+	static constexpr size_t C_HEADER_SIZE = 61;
+
+	static size_t size ( std::string_view a ) { return 2 + 4 + a.size ( ); }
+	static size_t size ( int ) { return 2 + 4; }
+	static size_t size ( unsigned int ) { return 2 + 4; }
+	static size_t size ( float ) { return 2 + 4; }
+	static size_t size ( const CL_Vec2<float>& ) { return 2 + 8; }
+	static size_t size ( const CL_Vec3<float>& ) { return 2 + 12; }
+	template<size_t N>
+	static size_t size ( const VariantConcat<N>& a )
+	{
+		size_t total = 2 + 4;
+		for ( std::string_view part : a.parts ) total += part.size ( );
+		return total;
+	}
+
+	static void write ( BYTE*& cursor , BYTE index , std::string_view a )
+	{
+		begin ( cursor , index , 0x2 );
+		put ( cursor , static_cast<int>( a.size ( ) ) );
+		std::memcpy ( cursor , a.data ( ) , a.size ( ) );
+		cursor += a.size ( );
+	}
+	static void write ( BYTE*& cursor , BYTE index , int a ) { begin ( cursor , index , 0x9 ); put ( cursor , a ); }
+	static void write ( BYTE*& cursor , BYTE index , unsigned int a ) { begin ( cursor , index , 0x5 ); put ( cursor , a ); }
+	static void write ( BYTE*& cursor , BYTE index , float a ) { begin ( cursor , index , 0x1 ); put ( cursor , a ); }
+	static void write ( BYTE*& cursor , BYTE index , const CL_Vec2<float>& a )
+	{
+		begin ( cursor , index , 0x3 );
+		put ( cursor , a.X );
+		put ( cursor , a.Y );
+	}
+	static void write ( BYTE*& cursor , BYTE index , const CL_Vec3<float>& a )
+	{
+		begin ( cursor , index , 0x4 );
+		put ( cursor , a.X );
+		put ( cursor , a.Y );
+		put ( cursor , a.Z );
+	}
+	template<size_t N>
+	static void write ( BYTE*& cursor , BYTE index , const VariantConcat<N>& a )
+	{
+		begin ( cursor , index , 0x2 );
+		BYTE* length = cursor;
+		cursor += 4;
+		for ( std::string_view part : a.parts )
+		{
+			std::memcpy ( cursor , part.data ( ) , part.size ( ) );
+			cursor += part.size ( );
+		}
+		int str_len = static_cast<int>( cursor - length - 4 );
+		std::memcpy ( length , &str_len , 4 );
+	}
+
+	// String-likes (std::string, literals) are encoded through std::string_view
+	template<typename T>
+	static decltype( auto ) value ( const T& a )
+	{
+		if constexpr ( std::is_convertible_v<const T&, std::string_view> ) return std::string_view ( a );
+		else return ( a );
+	}
+
+private:
+	static void begin ( BYTE*& cursor , BYTE index , BYTE type )
+	{
+		cursor[ 0 ] = index;
+		cursor[ 1 ] = type;
+		cursor += 2;
+	}
+	template<typename T>
+	static void put ( BYTE*& cursor , const T& a )
+	{
+		std::memcpy ( cursor , &a , sizeof ( T ) );
+		cursor += sizeof ( T );
+	}
+};
+
+/**
+ * Build a call function packet in one allocation, the arguments are written straight into the ENetPacket
+ *
+ * make_variant_packet ( "OnConsoleMessage" , msg );
+ * make_variant_packet ( VariantOptions{ 1000 } , "OnDialogRequest" , dialog );
+ *
+ * @return Reliable packet, nullptr if it could not be allocated
+ */
+template<typename... Args>
+ENetPacket* make_variant_packet ( const VariantOptions& options , const Args&... args )
+{
+	static_assert( sizeof...( Args ) < 256 , "A variant list holds at most 255 arguments" );
+
+	size_t size = VariantEncoder::C_HEADER_SIZE + ( VariantEncoder::size ( VariantEncoder::value ( args ) ) + ... + 0 );
+	ENetPacket* packet = enet_packet_create ( nullptr , size , ENET_PACKET_FLAG_RELIABLE );
+	if ( packet == nullptr ) return nullptr;
+
+	int MessageType = 0x4 , PacketType = 0x1 , CharState = 0x8;
+	BYTE* data = packet->data;
+	std::memset ( data , 0 , VariantEncoder::C_HEADER_SIZE );
+	std::memcpy ( data , &MessageType , 4 );
+	std::memcpy ( data + 4 , &PacketType , 4 );
+	std::memcpy ( data + 8 , &options.NetID , 4 );
+	std::memcpy ( data + 16 , &CharState , 4 );
+	std::memcpy ( data + 24 , &options.delay , 4 );
+	data[ 60 ] = static_cast<BYTE>( sizeof...( Args ) );
+
+	BYTE* cursor = data + VariantEncoder::C_HEADER_SIZE;
+	BYTE index = 0;
+	( VariantEncoder::write ( cursor , index++ , VariantEncoder::value ( args ) ) , ... );
+	return packet;
+}
+
+template<typename... Args>
+ENetPacket* make_variant_packet ( const char* function , const Args&... args )
+{
+	return make_variant_packet ( VariantOptions{ } , function , args... );
+}
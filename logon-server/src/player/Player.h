@@ -9,6 +9,9 @@
 
 #include "RoleManager.h"
 
+#include <server/PeerHandle.h>
+#include <server/handler/HandlerContext.h>
+
 enum ePlatformType {
 	PLATFORM_ID_UNKNOWN = -1 ,
 	PLATFORM_ID_WINDOWS , // 0
@@ -29,12 +32,17 @@ struct PlayerCredentials {
   std::string tankIDPass = "";
   std::string RID = "";
   std::string IPv4 = "127.0.0.1";
+  enet_uint32 address = 0;  // Same as peer->address.host, use it for lookups instead of IPv4
 };
 
 class Player {
   private:
     PlayerCredentials credentials;
     RoleManager roles;
+    bool validated = false;
+    bool disconnecting = false;
+    PeerHandle handle;
+    std::string merchant;
 
   public:
     nlohmann::json tData;
@@ -57,10 +65,51 @@ class Player {
       return roles;
     }
 
+    // Set once the IP-reputation check of this connection has passed
+    void set_validated(const bool& status) {
+      std::lock_guard<std::mutex> lock(mtx);
+      validated = status;
+    }
+    bool is_validated() {
+      std::lock_guard<std::mutex> lock(mtx);
+      return validated;
+    }
+
+    // Issued by the shard on connect, the only way to reach the peer from other threads
+    void set_handle(const PeerHandle& data) {
+      std::lock_guard<std::mutex> lock(mtx);
+      handle = data;
+    }
+    PeerHandle get_handle() {
+      std::lock_guard<std::mutex> lock(mtx);
+      return handle;
+    }
+
+    // Merchant the player logged in through, also kept in tData for the handlers
+    void set_merchant(const std::string& name) {
+      std::lock_guard<std::mutex> lock(mtx);
+      merchant = name;
+    }
+    bool is_merchant(std::string_view name) {
+      std::lock_guard<std::mutex> lock(mtx);
+      return merchant == name;
+    }
+
+    // Set when a handler asked to drop the peer, later packets are ignored
+    void set_disconnecting(const bool& status) {
+      std::lock_guard<std::mutex> lock(mtx);
+      disconnecting = status;
+    }
+    bool is_disconnecting() {
+      std::lock_guard<std::mutex> lock(mtx);
+      return disconnecting;
+    }
+
   private:
     mutable std::mutex mtx;
 };
 
-#define pInfo(peer) ((Player*)(peer->data))
+// Handlers running on a HandlerPool worker never read peer->data, they get the player bound to their context
+#define pInfo(peer) (HandlerContext::current() ? HandlerContext::current()->player : (Player*)(peer->data))
 #define pClient pInfo(peer)
 #define cpClient pInfo(currentPeer)
\ No newline at end of file
@@ -2,15 +2,30 @@
 
 #include <BaseApp.h>
 
+#include <string>
+#include <mutex>
+
 struct ServerConfig {
   std::string server_ip = "127.0.0.1";
   int server_port = 17091;
   std::string default_name = "GTPS Gateway";
+  int enet_shards = 1;
+  int handler_workers = 4;
+  std::string snapshot_dir = "../snapshot/";
+  int snapshot_interval = 60;     /** <- Seconds between cache snapshots, 0 = only on shutdown */
+  int write_behind_ms = 1000;     /** <- Window database writes are coalesced in, 0 = write through */
+  bool json_export = false;       /** <- Mirror catalog changes to the JSON layout in the background */
+  std::string store_dir = "../../../database/store/";
+  int store_compact_kb = 16 * 1024; /** <- Log size that triggers a store snapshot, 0 = never */
+  int session_ttl_days = 30;      /** <- Unused sessions and redirect tickets expire after this, 0 = never */
+  bool redirect_tickets = false;  /** <- Hand out signed RedirectTickets instead of storing sessions */
+  std::string ticket_secret;      /** <- HMAC key of the tickets, generated on first start */
 };
 
 class DataManager {
   private:
     static ServerConfig server_config;
+    static std::recursive_mutex database_mtx;
 
   public:
     static void load_all() {
@@ -26,6 +41,13 @@ class DataManager {
     static const ServerConfig& get_server_config() {
       return server_config;
     }
+    // Guards read-modify-write of the database files, shared by every ENetServer shard
+    static std::recursive_mutex& get_database_mutex() {
+      return database_mtx;
+    }
+    // Warm-restart state of the recent-login addresses, see snapshot_dir
+    static void load_cache_snapshot();
+    static void save_cache_snapshot();
     static void load_server_config(const std::string path = "../config.json");
     static void save_server_config(const std::string path = "../config.json");
 };
@@ -2,15 +2,56 @@
 
 #include <utils/FileSystem2.h>
 #include <utils/ConsoleInterface.h>
+#include <server/PeerValidator.h>
+
+#include <random>
 
 ServerConfig DataManager::server_config = {};
+std::recursive_mutex DataManager::database_mtx;
+
+// 32 random bytes as hex
+static std::string generate_secret() {
+  std::random_device rd;
+  std::string secret;
+  for (int i = 0; i < 8; i++)
+    secret += fmt::format("{:08x}", static_cast<uint32_t>(rd()));
+  return secret;
+}
+void DataManager::load_cache_snapshot() {
+  size_t addresses = PeerValidator::known_addresses().loadSnapshot(server_config.snapshot_dir + "addresses.bin");
+  print_info("Restored {} known addresses from snapshot.", addresses);
+}
+void DataManager::save_cache_snapshot() {
+  // Periodic and shutdown snapshots may overlap, both write the same temp file
+  static std::mutex snapshot_mtx;
+  std::lock_guard<std::mutex> lock(snapshot_mtx);
+
+  if (!PeerValidator::known_addresses().saveSnapshot(server_config.snapshot_dir + "addresses.bin"))
+    print_warning("Failed to write known addresses snapshot to {}", server_config.snapshot_dir);
+}
 void DataManager::load_server_config(const std::string path) {
   try {
     nlohmann::json data = FileSystem2::readJson(path);
     server_config.server_ip = data["server_ip"].get<std::string>();
     server_config.server_port = data["server_port"].get<int>();
     server_config.default_name = data["default_name"].get<std::string>();
+    server_config.enet_shards = data.value("enet_shards", 1);
+    server_config.handler_workers = data.value("handler_workers", 4);
+    server_config.snapshot_dir = data.value("snapshot_dir", "../snapshot/");
+    server_config.snapshot_interval = data.value("snapshot_interval", 60);
+    server_config.write_behind_ms = data.value("write_behind_ms", 1000);
+    server_config.json_export = data.value("json_export", false);
+    server_config.store_dir = data.value("store_dir", "../../../database/store/");
+    server_config.store_compact_kb = data.value("store_compact_kb", 16 * 1024);
+    server_config.session_ttl_days = data.value("session_ttl_days", 30);
+    server_config.redirect_tickets = data.value("redirect_tickets", false);
+    server_config.ticket_secret = data.value("ticket_secret", "");
 
+    // Tickets signed with an empty key would be forgeable, a fresh key only invalidates tickets in flight
+    if (server_config.ticket_secret.empty()) {
+      server_config.ticket_secret = generate_secret();
+      save_server_config(path);
+    }
     return;
   }
   catch (const nlohmann::json::exception& e) {
@@ -22,6 +63,8 @@ void DataManager::load_server_config(const std::string path) {
   catch (const std::exception& e) {
     print_error("{}", e.what());
   }
+  if (server_config.ticket_secret.empty())
+    server_config.ticket_secret = generate_secret();
   save_server_config();
 }
 void DataManager::save_server_config(const std::string path) {
@@ -30,6 +73,17 @@ void DataManager::save_server_config(const std::string path) {
     data["server_ip"] = server_config.server_ip;
     data["server_port"] = server_config.server_port;
     data["default_name"] = server_config.default_name;
+    data["enet_shards"] = server_config.enet_shards;
+    data["handler_workers"] = server_config.handler_workers;
+    data["snapshot_dir"] = server_config.snapshot_dir;
+    data["snapshot_interval"] = server_config.snapshot_interval;
+    data["write_behind_ms"] = server_config.write_behind_ms;
+    data["json_export"] = server_config.json_export;
+    data["store_dir"] = server_config.store_dir;
+    data["store_compact_kb"] = server_config.store_compact_kb;
+    data["session_ttl_days"] = server_config.session_ttl_days;
+    data["redirect_tickets"] = server_config.redirect_tickets;
+    data["ticket_secret"] = server_config.ticket_secret;
 
     FileSystem2::writeJson(path, data);
   }
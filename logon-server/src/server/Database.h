@@ -0,0 +1,148 @@
+#pragma once
+
+#include <BaseApp.h>
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <functional>
+#include <nlohmann/json.hpp>
+
+#include <utils/LogStore.h>
+#include <server/MerchantCatalog.h>
+
+// How a record type is stored as a LogStore value
+template<typename T>
+struct RecordCodec {
+  static std::string encode(const T& value) { return value.to_json().dump(); }
+  static T decode(const std::string&, const std::string& data) { return T::from_json(nlohmann::json::parse(data)); }
+};
+template<>
+struct RecordCodec<ServerList> {
+  static std::string encode(const ServerList& value) { return value.to_json().dump(); }
+  static ServerList decode(const std::string& key, const std::string& data) { return ServerList::from_json(key, nlohmann::json::parse(data)); }
+};
+template<>
+struct RecordCodec<nlohmann::json> {
+  static std::string encode(const nlohmann::json& value) { return value.dump(); }
+  static nlohmann::json decode(const std::string&, const std::string& data) { return nlohmann::json::parse(data); }
+};
+template<>
+struct RecordCodec<std::string> {
+  static std::string encode(const std::string& value) { return value; }
+  static std::string decode(const std::string&, const std::string& data) { return data; }
+};
+template<>
+struct RecordCodec<std::vector<std::string>> {
+  static std::string encode(const std::vector<std::string>& value) { return nlohmann::json(value).dump(); }
+  static std::vector<std::string> decode(const std::string&, const std::string& data) { return nlohmann::json::parse(data).get<std::vector<std::string>>(); }
+};
+
+/**
+ * StoreTable
+ * Typed view over one LogStore table, values go through RecordCodec<T>.
+ */
+template<typename T>
+class StoreTable {
+  private:
+    LogStore& store;
+    const char* name;
+
+  public:
+    StoreTable(LogStore& store, const char* name) : store(store), name(name) {}
+
+    std::optional<T> get(const std::string& key) const {
+      std::optional<std::string> data = store.get(name, key);
+      if (!data)
+        return std::nullopt;
+      return RecordCodec<T>::decode(key, *data);
+    }
+    void put(const std::string& key, const T& value) {
+      store.put(name, key, RecordCodec<T>::encode(value));
+    }
+    void erase(const std::string& key) {
+      store.erase(name, key);
+    }
+    bool exists(const std::string& key) const {
+      return store.exists(name, key);
+    }
+    size_t size() const {
+      return store.size(name);
+    }
+    // Records failing to decode are skipped
+    void for_each(const std::function<void(const std::string& key, const T& value)>& fn) const {
+      store.forEach(name, [&](const std::string& key, const std::string& data) {
+        try {
+          fn(key, RecordCodec<T>::decode(key, data));
+        }
+        catch (const std::exception&) {}
+      });
+    }
+};
+
+/**
+ * Database
+ * Gateway state kept in an embedded LogStore instead of loose JSON files.
+ *
+ * Every write is one append to the store log, committed in groups by the
+ * store. The JSON layout under database/ stays the exchange format: an empty
+ * store imports it on open, export_json writes it back.
+ *
+ * Tables:
+ *   merchants      merchant name  -> Merchant
+ *   servers        servers_key    -> ServerList
+ *   registrations  IPv4           -> merchant names registered from it
+ *   sessions       session token  -> Session::encode(), kept in memory by SessionStore
+ *   ledger         "coin"         -> { "used", "produced" }
+ *
+ * Example usage:
+ * @code
+ * Database::open("../../../database/store/", "../../../database/");
+ * Database::sessions().put(session, param);
+ * if (auto param = Database::sessions().get(session)) {
+ *   // Redirect the player
+ * }
+ * Database::close();
+ * @endcode
+ */
+class Database {
+  private:
+    static LogStore store;
+
+  public:
+    /**
+     * Open the store, importing the JSON layout if the store is empty
+     *
+     * @param store_dir - Directory of the store files
+     * @param json_dir - Database directory in the JSON layout
+     * @return False if the store cannot be opened
+     */
+    static bool open(const std::string& store_dir, const std::string& json_dir);
+    static void close();
+    static bool is_open() {
+      return store.isOpen();
+    }
+    static LogStore& get_store() {
+      return store;
+    }
+
+    /**
+     * Copy merchants/, servers/, registered.json, transactions.json and sessions/ into the store
+     *
+     * @return Amount of records imported
+     */
+    static size_t import_json(const std::string& json_dir);
+
+    /**
+     * Write every table back to the JSON layout, files are replaced atomically
+     *
+     * @return Amount of files written
+     */
+    static size_t export_json(const std::string& json_dir);
+
+    static StoreTable<Merchant> merchants() { return { store, "merchants" }; }
+    static StoreTable<ServerList> servers() { return { store, "servers" }; }
+    static StoreTable<std::vector<std::string>> registrations() { return { store, "registrations" }; }
+    static StoreTable<std::string> sessions() { return { store, "sessions" }; }
+    static StoreTable<nlohmann::json> ledger() { return { store, "ledger" }; }
+};
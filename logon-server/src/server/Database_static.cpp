@@ -0,0 +1,113 @@
+#include "Database.h"
+
+#include <filesystem>
+
+#include <utils/ConsoleInterface.h>
+#include <utils/FileSystem2.h>
+#include <server/WriteBehind.h>
+
+LogStore Database::store;
+
+bool Database::open(const std::string& store_dir, const std::string& json_dir) {
+  if (!store.open(store_dir))
+    return false;
+
+  LogStore::Stats stats = store.getStats();
+  if (stats.records == 0) {
+    size_t imported = import_json(json_dir);
+    store.sync();
+    print_info("Imported {} records from {} into the store.", imported, json_dir);
+  }
+  else {
+    print_info("Store opened with {} records, {} log records replayed.", stats.records, stats.replayed);
+  }
+  return true;
+}
+void Database::close() {
+  store.close();
+}
+size_t Database::import_json(const std::string& json_dir) {
+  size_t imported = 0;
+  std::error_code ec;
+
+  auto import_dir = [&](const std::string& dir, const std::function<void(const std::filesystem::path& path)>& fn) {
+    for (const auto& entry : std::filesystem::directory_iterator(json_dir + dir, ec)) {
+      if (!entry.is_regular_file())
+        continue;
+
+      try {
+        fn(entry.path());
+        imported++;
+      }
+      catch (const std::exception& e) {
+        print_error("Failed to import {}: {}", entry.path().string(), e.what());
+      }
+    }
+  };
+
+  import_dir("merchants/", [](const std::filesystem::path& path) {
+    if (path.extension() == ".json")
+      merchants().put(path.stem().string(), Merchant::from_json(FileSystem2::readJson(path.string())));
+  });
+  import_dir("servers/", [](const std::filesystem::path& path) {
+    std::string key = path.stem().string();
+    if (path.extension() == ".json")
+      servers().put(key, ServerList::from_json(key, FileSystem2::readJson(path.string())));
+  });
+  import_dir("sessions/", [](const std::filesystem::path& path) {
+    sessions().put(path.filename().string(), FileSystem2::readFile(path.string()));
+  });
+
+  try {
+    if (std::filesystem::exists(json_dir + "registered.json")) {
+      nlohmann::json reg = FileSystem2::readJson(json_dir + "registered.json");
+      for (const auto& [address, names] : reg.items()) {
+        registrations().put(address, names.get<std::vector<std::string>>());
+        imported++;
+      }
+    }
+    if (std::filesystem::exists(json_dir + "transactions.json")) {
+      nlohmann::json transactions = FileSystem2::readJson(json_dir + "transactions.json");
+      for (const auto& [key, value] : transactions.items()) {
+        ledger().put(key, value);
+        imported++;
+      }
+    }
+  }
+  catch (const std::exception& e) {
+    print_error("Failed to import {}: {}", json_dir, e.what());
+  }
+
+  return imported;
+}
+size_t Database::export_json(const std::string& json_dir) {
+  size_t written = 0;
+
+  merchants().for_each([&](const std::string& name, const Merchant& merchant) {
+    WriteBehind::write(json_dir + "merchants/" + name + ".json", [data = merchant.to_json()] { return data.dump(4); });
+    written++;
+  });
+  servers().for_each([&](const std::string& key, const ServerList& servers) {
+    WriteBehind::write(json_dir + "servers/" + key + ".json", [data = servers.to_json()] { return data.dump(4); });
+    written++;
+  });
+  sessions().for_each([&](const std::string& session, const std::string& param) {
+    WriteBehind::write(json_dir + "sessions/" + session, [param] { return param; });
+    written++;
+  });
+
+  nlohmann::json reg = nlohmann::json::object();
+  registrations().for_each([&](const std::string& address, const std::vector<std::string>& names) {
+    reg[address] = names;
+  });
+  WriteBehind::write(json_dir + "registered.json", [reg] { return reg.dump(4); });
+
+  nlohmann::json transactions = nlohmann::json::object();
+  ledger().for_each([&](const std::string& key, const nlohmann::json& value) {
+    transactions[key] = value;
+  });
+  WriteBehind::write(json_dir + "transactions.json", [transactions] { return transactions.dump(4); });
+
+  WriteBehind::flush();
+  return written + 2;
+}
@@ -2,20 +2,27 @@
 
 #include "handler/NetMessageGameMessage.h"
 
-#include <utils/CacheManager.h>
+#include "DataManager.h"
+#include "SessionStore.h"
 
-ENetServer::ENetServer(const ENetAddress& address): m_address(address) {
-  std::string host = get_host_ip(&m_address);
+#include <utils/SystemUtils.h>
 
-  m_server = enet_host_create(&m_address, m_max_peer, 0, m_max_incoming_bandwidth, m_max_outgoing_bandwidth);
-  if (m_server == nullptr) {
-    throw std::runtime_error("Failed to creating enet server.");
+#if IS_LINUX
+  #include <sys/socket.h>
+#endif
+
+ENetServer::ENetServer(const ENetAddress& address, size_t shards): m_address(address) {
+  m_host = get_host_ip(&m_address);
+
+  #if !defined(SO_REUSEPORT)
+  if (shards > 1) {
+    print_warning("SO_REUSEPORT is not supported on this platform, falling back to a single shard.");
+    shards = 1;
   }
-  m_server->checksum = enet_crc32;
-  m_server->usingNewPacketForServer = 1;
-  enet_host_compress_with_range_coder(m_server);
+  #endif
+  m_shard_count = (shards == 0 ? 1 : shards);
 
-  print_debug("New ENetServer created {}:{}", host, m_address.port);
+  print_debug("New ENetServer created {}:{} ({} shards)", m_host, m_address.port, m_shard_count);
 }
 ENetServer::~ENetServer() {
   #if IS_DEBUG
@@ -30,118 +37,325 @@ ENetServer::~ENetServer() {
   print_warning("ENetServer destroyed {}:{}", host, m_address.port);
   #endif
 
-  delete m_server;
-  m_server = nullptr;
+  shutdown();
   m_address.host = 0;
   m_address.port = 0;
 }
+void ENetServer::shutdown() {
+  // Shards still serving would use the hosts destroyed below
+  stop();
+  for (auto& shard : m_shards) {
+    if (shard->thread.joinable())
+      shard->thread.join();
+  }
+
+  // Handler tasks hold ENetPeer* and push into the shard queues, both die with the hosts
+  HandlerPool::stop();
+
+  for (auto& shard : m_shards) {
+    if (shard->host)
+      enet_host_destroy(shard->host);
+    shard->host = nullptr;
+  }
+}
+ENetHost* ENetServer::create_host() {
+  ENetHost* host = nullptr;
+
+  if (m_shard_count == 1) {
+    host = enet_host_create(&m_address, m_max_peer, 0, m_max_incoming_bandwidth, m_max_outgoing_bandwidth);
+    if (host == nullptr) {
+      throw std::runtime_error("Failed to creating enet server.");
+    }
+  }
+  else {
+    #if defined(SO_REUSEPORT)
+    // Create the host unbound, SO_REUSEPORT has to be set before bind so
+    // every shard can listen on the same port
+    host = enet_host_create(nullptr, m_max_peer, 0, m_max_incoming_bandwidth, m_max_outgoing_bandwidth);
+    if (host == nullptr) {
+      throw std::runtime_error("Failed to creating enet server.");
+    }
+
+    int enable = 1;
+    if (setsockopt(host->socket, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) != 0 || enet_socket_bind(host->socket, &m_address) < 0) {
+      enet_host_destroy(host);
+      throw std::runtime_error("Failed to bind enet shard with SO_REUSEPORT.");
+    }
+    host->address = m_address;
+    #endif
+  }
+
+  host->checksum = enet_crc32;
+  host->usingNewPacketForServer = 1;
+  enet_host_compress_with_range_coder(host);
+
+  return host;
+}
 std::thread* ENetServer::service() {
-  m_service_thread = std::thread([&] {
-    ENetEvent event;
-    std::string sIP = get_host_ip(&m_address);
-    print_success("ENetServer started with {}:{}", sIP, m_address.port);
-
-    while (true) {
-      if (!m_server || m_server == nullptr) {
-        throw std::runtime_error("Server is null pointer.");
-      }
-      if (m_paused) {
-        continue;
+  for (size_t i = 0; i < m_shard_count; i++) {
+    auto shard = std::make_unique<Shard>();
+    shard->id = i;
+    shard->host = create_host();
+    shard->generations.assign(shard->host->peerCount, 0);
+    shard->validator = std::make_unique<PeerValidator>(m_validation_workers);
+    m_shards.emplace_back(std::move(shard));
+  }
+
+  for (auto& shard : m_shards) {
+    shard->thread = std::thread(&ENetServer::run, this, shard.get());
+    if (m_pin_threads && m_shard_count > 1 && !SystemUtils::pinThreadToCore(shard->thread, shard->id)) {
+      print_warning("Failed to pin ENetServer shard {} to core {}", shard->id, shard->id);
+    }
+  }
+
+  return &m_shards.front()->thread;
+}
+void ENetServer::run(Shard* shard) {
+  ENetEvent event;
+  print_success("ENetServer shard {} started with {}:{}", shard->id, m_host, m_address.port);
+
+  // Cache housekeeping is global, one shard is enough to run it
+  bool housekeeper = shard->id == 0;
+  TimePoint next_housekeeping = current_time();
+  TimePoint next_snapshot = current_time() + m_snapshot_interval;
+  TimePoint next_session_sweep = current_time() + SESSION_SWEEP_INTERVAL;
+
+  while (m_running) {
+    if (!shard->host || shard->host == nullptr) {
+      throw std::runtime_error("Server is null pointer.");
+    }
+    if (m_paused) {
+      continue;
+    }
+
+    // Wait for the first event, then take everything already received without blocking again
+    int status = enet_host_service(shard->host, &event, SERVICE_TIMEOUT_MS);
+    while (status > 0) {
+      handle_event(shard, event);
+      status = enet_host_check_events(shard->host, &event);
+    }
+
+    apply_validation_results(shard);
+    drain_outbound(shard);
+
+    if (housekeeper && current_time() >= next_housekeeping) {
+      PeerValidator::known_addresses().cleanupExpired();
+      next_housekeeping = current_time() + HOUSEKEEPING_INTERVAL;
+    }
+    if (housekeeper && m_snapshot_interval.count() > 0 && current_time() >= next_snapshot) {
+      // File I/O stays off the service thread, the server itself is the strand so snapshots never pile up in parallel
+      HandlerPool::post(this, [] { DataManager::save_cache_snapshot(); });
+      next_snapshot = current_time() + m_snapshot_interval;
+    }
+    if (housekeeper && current_time() >= next_session_sweep) {
+      HandlerPool::post(this, [] { SessionStore::sweep(); });
+      next_session_sweep = current_time() + SESSION_SWEEP_INTERVAL;
+    }
+  }
+}
+void ENetServer::handle_event(Shard* shard, ENetEvent& event) {
+  ENetPeer* peer = event.peer;
+  std::string pIP = get_host_ip(&peer->address);
+
+  switch (event.type) {
+    case ENET_EVENT_TYPE_CONNECT: {
+      if (peer->data != NULL) {
+        enet_peer_disconnect_later(peer, 0);
+        Utils::release_peer_data(peer);
+        break;
       }
+      print_debug("[{}:{}] Peer with {}:{} connected to server.", m_host, m_address.port, pIP, peer->address.port);
+
+      peer->data = new Player();
+      pClient->set_handle({ &shard->outbound, peer->incomingPeerID, ++shard->generations[peer->incomingPeerID] });
+      PlayerCredentials data = pClient->get_credentials();
+      data.IPv4 = pIP;
+      data.address = peer->address.host;
+      pClient->set_credentials(data);
       
-      if (enet_host_service(m_server, &event, 100) > 0) {
-        ENetPeer* peer = event.peer;
-        std::string pIP = get_host_ip(&peer->address);
-
-        switch (event.type) {
-          case ENET_EVENT_TYPE_CONNECT: {
-            if (peer->data != NULL) {
-              Utils::disconnect_peer(peer);
-              break;
-            }
-            print_debug("[{}:{}] Peer with {}:{} connected to server.", sIP, m_address.port, pIP, peer->address.port);
-
-            peer->data = new Player();
-            PlayerCredentials data = pClient->get_credentials();
-            data.IPv4 = pIP;
-            pClient->set_credentials(data);
-            
-            enet_peer_timeout(peer, 5000, 3000, 10000);
-
-            VariantList::OnConsoleMessage(peer, "`oValidating request...");
-            enet_host_flush(m_server);
-            
-            Curl curl;
-            curl.setUrl("http://localhost:8080/check-ip/" + pIP);
-            curl.setTimeout((CacheManager::exists(pIP) ? 2 : 5));
-            curl.setSSLVerification(false);
-
-            if (curl.perform()) {
-              try {
-                nlohmann::json response = nlohmann::json::parse(curl.getResponseData());
-                bool dc = false;
-                if ((response.contains("status") && response["status"] == true) || (response.contains("is_vps") && response["is_vpn"] == true) || (response.contains("is_vps") && response["is_vps"] == true) || (response.contains("is_proxy") && response["is_proxy"] == true)) {
-                  VariantList::OnConsoleMessage(peer, "`o`4Oops``: It appears you're using a `4prohibited third-party application`` or logging in with a `4prohibited address``. If this is a false alert, please contact the `0merchant owner`` or try login again.");
-                  dc = true;
-                }
-                if (response.contains("presentence") && response["presentence"] >= 85) {
-                  VariantList::OnConsoleMessage(peer, "`o`6Warning``: It appears you're using a `4prohibited third-party application`` or logging in with a `4prohibited address``.");
-                }
-
-                if (dc) {
-                  Utils::disconnect_peer(peer);
-                  break;
-                }
-              }
-              catch (...) {}
-            }
-
-            Utils::SendPacket(peer, 1, nullptr, 0);
-            break;
-          }
-          case ENET_EVENT_TYPE_RECEIVE: {
-            std::string pkt_txt = get_packet_text(event.packet);
-            TextScanner ctx(pkt_txt.c_str());
-            int packet_type = get_packet_type(event.packet);
-            print_debug("[{}:{}] Packet {} receive from Peer {}:{} >> {}", sIP, m_address.port, packet_type, pIP, peer->address.port, pkt_txt);
-
-            switch(packet_type) {
-              case NET_MESSAGE_GENERIC_TEXT: {
-                NetMessageGenericTextHandler::execute(peer, &ctx);
-                break;
-              }
-              case NET_MESSAGE_GAME_MESSAGE: {
-                NetMessageGameMessageHandler::execute(peer, &ctx);
-                break;
-              }
-              default: {
-                print_warning("Unhandled net packet type: {} sended by peer {}:{}", packet_type, pIP, peer->address.host);
-              }
-            }
-
-            enet_packet_destroy(event.packet);
-            break;
-          }
-          case ENET_EVENT_TYPE_DISCONNECT: {
-            print_debug("[{}:{}] Player with {}:{} disconnected from server.", 
-                        sIP, m_address.port, pIP, peer->address.port);
-            
-            // Cleanup peer data
-            if (peer->data) {
-              delete peer->data;
-              peer->data = NULL;
-            }
-            break;
-          }
-          default: {
-            print_warning("Unknown event type rechived from peer {}:{}", pIP, peer->address.port);
-            break;
-          }
+      enet_peer_timeout(peer, 5000, 3000, 10000);
+
+      // Hello is sent once the lookup comes back, see apply_validation_results()
+      Utils::SendConstPacket(peer, ConstPacketId::VALIDATING_REQUEST);
+      shard->validator->submit(peer, pIP);
+      break;
+    }
+    case ENET_EVENT_TYPE_RECEIVE: {
+      if (!Utils::PeerValidation(peer) || !pClient->is_validated()) {
+        enet_packet_destroy(event.packet);
+        break;
+      }
+
+      int packet_type = get_packet_type(event.packet);
+      print_debug("[{}:{}] Packet {} receive from Peer {}:{} >> {}", m_host, m_address.port, packet_type, pIP, peer->address.port, get_packet_text(event.packet));
+
+      switch(packet_type) {
+        case NET_MESSAGE_GENERIC_TEXT:
+        case NET_MESSAGE_GAME_MESSAGE: {
+          // The handler reads the text in place, the packet is destroyed once it finished
+          dispatch(peer, packet_type, event.packet);
+          break;
+        }
+        default: {
+          print_warning("Unhandled net packet type: {} sended by peer {}:{}", packet_type, pIP, peer->address.host);
+          enet_packet_destroy(event.packet);
         }
       }
-      CacheManager::cleanupExpired();
+      break;
+    }
+    case ENET_EVENT_TYPE_DISCONNECT: {
+      print_debug("[{}:{}] Player with {}:{} disconnected from server.", 
+                  m_host, m_address.port, pIP, peer->address.port);
+      
+      // Cleanup peer data, anything still queued for this connection gets dropped
+      shard->generations[peer->incomingPeerID]++;
+      Utils::release_peer_data(peer);
+      break;
+    }
+    default: {
+      print_warning("Unknown event type rechived from peer {}:{}", pIP, peer->address.port);
+      break;
+    }
+  }
+}
+void ENetServer::apply_validation_results(Shard* shard) {
+  std::vector<ValidationResult> results;
+  if (shard->validator->poll(results) == 0)
+    return;
+
+  for (const auto& result : results) {
+    ENetPeer* peer = result.peer;
+
+    // Peer left (or its slot got reused) while the lookup was in flight
+    if (!Utils::PeerValidation(peer) || peer->connectID != result.connect_id)
+      continue;
+
+    if (result.blocked) {
+      Utils::SendConstPacket(peer, ConstPacketId::ADDRESS_BLOCKED);
+    }
+    if (result.warned) {
+      Utils::SendConstPacket(peer, ConstPacketId::ADDRESS_WARNED);
+    }
+
+    if (result.blocked) {
+      Utils::disconnect_peer(peer);
+      continue;
+    }
+
+    pClient->set_validated(true);
+    Utils::SendConstPacket(peer, ConstPacketId::HELLO);
+  }
+}
+void ENetServer::dispatch(ENetPeer* peer, int packet_type, ENetPacket* packet) {
+  Player* player = pClient;
+  if (player->is_disconnecting()) {
+    enet_packet_destroy(packet);
+    return;
+  }
+
+  HandlerPool::post(player, [peer, player, packet_type, packet] {
+    HandlerContext ctx;
+    ctx.peer = peer;
+    ctx.player = player;
+
+    HandlerContext::current() = &ctx;
+    try {
+      // Lines and fields are views into the packet, no copy of the text is made
+      TextScanner pkt;
+      pkt.SetupFromView(get_packet_text(packet));
+      if (packet_type == NET_MESSAGE_GENERIC_TEXT)
+        NetMessageGenericTextHandler::execute(peer, &pkt);
+      else
+        NetMessageGameMessageHandler::execute(peer, &pkt);
+    }
+    catch (const std::exception& e) {
+      print_error("Unhandled exception in packet handler: {}", e.what());
     }
+    HandlerContext::current() = nullptr;
+    enet_packet_destroy(packet);
   });
+}
+void ENetServer::drain_outbound(Shard* shard) {
+  OutboundPacket item;
+  bool sent = false;
+
+  while (shard->outbound.pop(item)) {
+    if (item.flags & OUTBOUND_BROADCAST) {
+      send_broadcast(shard, item.packet, item.channel);
+      sent = true;
+      continue;
+    }
+
+    // Peer left (or its slot got reused) after this was queued
+    if (item.index >= shard->generations.size() || shard->generations[item.index] != item.generation) {
+      if (item.packet)
+        enet_packet_destroy(item.packet);
+      continue;
+    }
+    ENetPeer* peer = &shard->host->peers[item.index];
+
+    if (item.flags & OUTBOUND_DISCONNECT) {
+      enet_peer_disconnect_later(peer, 0);
+      Utils::release_peer_data(peer);
+      sent = true;
+      continue;
+    }
+
+    // Constant packets stay owned by the shard, enet_peer_send only adds a reference
+    bool constant = (item.flags & OUTBOUND_CONSTANT) != 0;
+    ENetPacket* packet = constant ? shard->constants.get(item.constant) : item.packet;
+    if (peer->state != ENET_PEER_STATE_CONNECTED || enet_peer_send(peer, item.channel, packet) < 0) {
+      if (!constant)
+        enet_packet_destroy(packet);
+      continue;
+    }
+    sent = true;
+  }
+
+  if (sent)
+    enet_host_flush(shard->host);
+}
+void ENetServer::broadcast(ENetPacket* packet, const BroadcastFilter& filter, enet_uint8 channel) {
+  if (packet == nullptr)
+    return;
+  if (m_shards.empty()) {
+    enet_packet_destroy(packet);
+    return;
+  }
+
+  // One packet per shard over the same bytes, referenceCount of each is only touched by its shard thread
+  Broadcast* shared = new Broadcast();
+  shared->source = packet;
+  shared->filter = filter;
+  shared->pending = m_shards.size();
+
+  for (auto& shard : m_shards) {
+    ENetPacket* view = enet_packet_create(packet->data, packet->dataLength, packet->flags | ENET_PACKET_FLAG_NO_ALLOCATE);
+    if (view == nullptr) {
+      shared->release();
+      continue;
+    }
+    view->userData = shared;
+    view->freeCallback = &ENetServer::release_broadcast;
+    shard->outbound.push({ 0, 0, view, channel, OUTBOUND_BROADCAST });
+  }
+}
+void ENetServer::send_broadcast(Shard* shard, ENetPacket* packet, enet_uint8 channel) {
+  const BroadcastFilter& filter = static_cast<Broadcast*>(packet->userData)->filter;
+
+  // Held while sending, every peer adds its own reference in enet_peer_send
+  packet->referenceCount++;
+  for (size_t i = 0; i < shard->host->peerCount; i++) {
+    ENetPeer* peer = &shard->host->peers[i];
+    if (peer->state != ENET_PEER_STATE_CONNECTED || peer->data == NULL)
+      continue;
+
+    Player* player = static_cast<Player*>(peer->data);
+    if (!player->is_validated() || player->is_disconnecting() || !filter.matches(player))
+      continue;
+    enet_peer_send(peer, channel, packet);
+  }
 
-  return &m_service_thread;
+  if (--packet->referenceCount == 0)
+    enet_packet_destroy(packet);
 }
@@ -4,11 +4,18 @@
 
 #include <thread>
 #include <string>
+#include <memory>
+#include <vector>
+#include <atomic>
 
 #include <enet/enet.h>
 
 #include <player/Player.h>
 #include "handler/NetMessageGenericText.h"
+#include "PeerValidator.h"
+#include "PeerHandle.h"
+#include "HandlerPool.h"
+#include "handler/HandlerContext.h"
 
 #include <utils/ConsoleInterface.h>
 #include <utils/Curl.h>
@@ -18,6 +25,20 @@
 
 #include <GlobalVar.h>
 
+/**
+ * Peers a broadcast is sent to, the default matches every validated player
+ */
+struct BroadcastFilter {
+  PlayerRole role = PlayerRole::NONE;   /** <- Required role, NONE for everyone */
+  std::string merchant;                 /** <- Merchant the player logged in through, empty for any */
+
+  bool matches(Player* player) const {
+    if (role != PlayerRole::NONE && !player->get_roles().has_role(role))
+      return false;
+    return merchant.empty() || player->is_merchant(merchant);
+  }
+};
+
 enum { 
   NET_MESSAGE_UNKNOWN = 0, 
   NET_MESSAGE_SERVER_HELLO, 
@@ -63,30 +84,61 @@ enum {
  * @endcode
  */
 class ENetServer {
+public:
+  /**
+   * One listener of the server: an ENetHost bound to the shared port and the
+   * thread serving it. Peers never move between shards, so everything attached
+   * to a peer is only touched by its shard thread.
+   */
+  struct Shard {
+    size_t id = 0;
+    ENetHost* host = nullptr;
+    std::thread thread;
+    std::unique_ptr<PeerValidator> validator;
+
+    // Packets sent to peers of this shard from any thread, drained by the shard thread
+    OutboundQueue outbound;
+    // Connection generation of every peer slot, see PeerHandle
+    std::vector<enet_uint32> generations;
+    // Pre-encoded packets of this shard, only sent from its thread
+    ConstPacketSet constants;
+  };
+
 private:
-  ENetHost* m_server = nullptr;
+  static constexpr enet_uint32 SERVICE_TIMEOUT_MS = 10;
+  static constexpr std::chrono::milliseconds HOUSEKEEPING_INTERVAL = std::chrono::milliseconds(1000);
+  static constexpr std::chrono::seconds SESSION_SWEEP_INTERVAL = std::chrono::seconds(60);
+
   ENetAddress m_address;
-  bool m_paused = false;
-  size_t m_max_peer = 1024;
+  std::string m_host;
+  std::atomic<bool> m_paused = false;
+  std::atomic<bool> m_running = true;
+  size_t m_max_peer = 1024;                   /** <- Per shard */
   enet_uint32 m_max_incoming_bandwidth = 0;   /** <- 0 for unlimited bandwidth */
   enet_uint32 m_max_outgoing_bandwidth = 0;   /** <- 0 for unlimited bandwidth */
-  std::thread m_service_thread;
+  size_t m_shard_count = 1;
+  bool m_pin_threads = true;
+  std::vector<std::unique_ptr<Shard>> m_shards;
+  size_t m_validation_workers = 8;            /** <- Per shard */
+  std::chrono::seconds m_snapshot_interval{ 0 };  /** <- 0 disables periodic cache snapshots */
 
 public:
   /**
    * Constructor for ENetServer
    * 
    * @param address - The network address to bind the host to server
+   * @param shards - Amount of ENetHost listening on the same address, each served by its own thread.
+   *                 Requires SO_REUSEPORT (Linux), other platforms always use a single shard.
    * 
    * Example:
    * @code
    * ENetAddress address;
    * enet_address_set_host(&address, "127.0.0.1");
    * address.port = 8080;
-   * ENetServer server(address);
+   * ENetServer server(address, 4);
    * @endcode
    */
-  ENetServer(const ENetAddress& address);
+  ENetServer(const ENetAddress& address, size_t shards = 1);
 
   /**
    * Destructor for ENetServer
@@ -95,7 +147,10 @@ public:
   ~ENetServer();
 
   /**
-   * Start server service
+   * Create the hosts and start one service thread per shard
+   * 
+   * @return Thread of the first shard, the others run alongside it
+   * @throws std::runtime_error If a host cannot be created or bound
    * 
    * Example:
    * @code
@@ -115,7 +170,7 @@ public:
    * server.set_pause(false); // Resume
    * @endcode
    */
-  void set_pause(const bool& status) { m_paused = status; }
+  void set_pause(const bool& status) { m_paused.store(status); }
 
   /**
    * Check if server is paused
@@ -127,7 +182,31 @@ public:
    * }
    * @endcode
    */
-  const bool& is_paused() const { return m_paused; }
+  bool is_paused() const { return m_paused.load(); }
+
+  /**
+   * Ask every shard to leave its service loop, the thread returned by service() then finishes
+   * Only stores an atomic flag, safe to call from a signal handler
+   * 
+   * Example:
+   * @code
+   * server.stop();
+   * @endcode
+   */
+  void stop() { m_running.store(false); }
+
+  /**
+   * Stop and join every shard, stop the HandlerPool, then destroy the hosts
+   * Handler tasks still running finish before the peers and outbound queues they use are freed.
+   * Called by the destructor, calling it earlier is safe
+   * 
+   * Example:
+   * @code
+   * server.service()->join();
+   * server.shutdown();
+   * @endcode
+   */
+  void shutdown();
 
   /**
    * Set maximum number of peers
@@ -200,6 +279,131 @@ public:
    */
   const enet_uint32& get_max_outgoing_bandwidth() const { return m_max_outgoing_bandwidth; }
 
+  /**
+   * Set amount of IP-reputation lookups that may run concurrently
+   * 
+   * @param amount worker threads used to validate new connections, must be set before service() is called.
+   * 
+   * Example:
+   * @code
+   * server.set_validation_workers(16);
+   * @endcode
+   */
+  void set_validation_workers(size_t amount) { m_validation_workers = amount; }
+
+  /**
+   * Get amount of IP-reputation lookups that may run concurrently
+   * 
+   * Example:
+   * @code
+   * size_t workers = server.get_validation_workers();
+   * @endcode
+   */
+  const size_t& get_validation_workers() const { return m_validation_workers; }
+
+  /**
+   * Get amount of shards actually used
+   * 
+   * Example:
+   * @code
+   * print_info("Listening with {} shards", server.get_shard_count());
+   * @endcode
+   */
+  const size_t& get_shard_count() const { return m_shard_count; }
+
+  /**
+   * Pin every shard thread to its own core
+   * 
+   * @param status true to pin shard N to core N (default), false to let the OS schedule them.
+   * 
+   * Example:
+   * @code
+   * server.set_pin_threads(false);
+   * @endcode
+   */
+  void set_pin_threads(const bool& status) { m_pin_threads = status; }
+
+  /**
+   * Set how often the cache snapshot is written in the background
+   * 
+   * @param interval time between snapshots, 0 to only write it on shutdown.
+   * 
+   * Example:
+   * @code
+   * server.set_snapshot_interval(std::chrono::seconds(60));
+   * @endcode
+   */
+  void set_snapshot_interval(std::chrono::seconds interval) { m_snapshot_interval = interval; }
+
+  /**
+   * Send one packet to every matching peer of every shard, safe from any thread once service() returned
+   * 
+   * @param packet - Encoded once and shared by all peers, the server takes ownership of it
+   * @param filter - Role and merchant the peers must match
+   * 
+   * Example:
+   * @code
+   * server.broadcast(make_variant_packet("OnConsoleMessage", "`4Maintenance in 5 minutes!"));
+   * server.broadcast(make_variant_packet("OnConsoleMessage", "Merchant notice"), { PlayerRole::MERCHANT });
+   * @endcode
+   */
+  void broadcast(ENetPacket* packet, const BroadcastFilter& filter = {}, enet_uint8 channel = 0);
+
+private:
+  /**
+   * Bytes and filter of a broadcast, shared by the per-shard packets pointing into them
+   */
+  struct Broadcast {
+    ENetPacket* source = nullptr;
+    BroadcastFilter filter;
+    std::atomic<size_t> pending{ 0 };   /** <- Shard packets still alive, the last one frees this */
+
+    void release() {
+      if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        enet_packet_destroy(source);
+        delete this;
+      }
+    }
+  };
+
+  static void release_broadcast(ENetPacket* packet);
+
+  /**
+   * Send a broadcast packet to the matching peers of a shard, called from the shard thread
+   */
+  void send_broadcast(Shard* shard, ENetPacket* packet, enet_uint8 channel);
+
+  /**
+   * Create and bind the host of a shard, sharing the port with SO_REUSEPORT when sharded
+   */
+  ENetHost* create_host();
+
+  /**
+   * Service loop of a shard, handles every ready event per iteration and flushes once
+   */
+  void run(Shard* shard);
+
+  /**
+   * Handle a single connect / receive / disconnect event of a shard
+   */
+  void handle_event(Shard* shard, ENetEvent& event);
+
+  /**
+   * Apply finished IP-reputation lookups to their peers, called from the shard thread
+   */
+  void apply_validation_results(Shard* shard);
+
+  /**
+   * Queue a received packet on the HandlerPool, in order with the other packets of the peer
+   * Ownership of the packet moves to the task, it is destroyed after the handler returned
+   */
+  void dispatch(ENetPeer* peer, int packet_type, ENetPacket* packet);
+
+  /**
+   * Send everything queued for the peers of a shard and flush once, called from the shard thread
+   */
+  void drain_outbound(Shard* shard);
+
 public:
   /**
    * Get host IP as string
@@ -25,4 +25,7 @@ int ENetServer::get_packet_type(ENetPacket* pkt) {
     return *(pkt->data);
   }
   return 0;
-}
\ No newline at end of file
+}
+void ENetServer::release_broadcast(ENetPacket* packet) {
+  static_cast<Broadcast*>(packet->userData)->release();
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <BaseApp.h>
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * GatewayStats
+ * Counters shown in the admin control panel, kept up to date as things happen.
+ *
+ * Reading them is a handful of atomic loads instead of walking the database.
+ * Merchant and session counts are seeded by MerchantCatalog and SessionStore
+ * on load and follow their changes. Coin totals are persisted as the "coin"
+ * record of the Database ledger:
+ *   used      coins spent renewing servers, or any other catalog update lowering a balance
+ *   produced  starting balance of merchants approved while running, plus any
+ *             catalog update raising a balance (a top up going through MerchantCatalog::update)
+ * Balances edited in the store or files behind the gateway's back are not counted.
+ *
+ * Example usage:
+ * @code
+ * GatewayStats::load();
+ * GatewayStats::sessions_changed(+1);
+ * GatewayStats::Counters counters = GatewayStats::get();
+ * @endcode
+ */
+class GatewayStats {
+  public:
+    struct Counters {
+      int64_t merchants;
+      int64_t sessions;
+      int64_t coin_used;
+      int64_t coin_produced;
+    };
+
+  private:
+    static std::atomic<int64_t> merchants;
+    static std::atomic<int64_t> sessions;
+    static std::atomic<int64_t> coin_used;
+    static std::atomic<int64_t> coin_produced;
+
+  public:
+    /**
+     * Restore the coin counters from the Database ledger
+     */
+    static void load();
+
+    static void set_merchants(int64_t amount) { merchants.store(amount, std::memory_order_relaxed); }
+    static void merchants_changed(int64_t delta) { merchants.fetch_add(delta, std::memory_order_relaxed); }
+    static void set_sessions(int64_t amount) { sessions.store(amount, std::memory_order_relaxed); }
+    static void sessions_changed(int64_t delta) { sessions.fetch_add(delta, std::memory_order_relaxed); }
+
+    /**
+     * Record coins spent and produced, persisted to the ledger
+     */
+    static void coins_changed(int64_t used, int64_t produced);
+
+    static Counters get() {
+      return {
+        merchants.load(std::memory_order_relaxed),
+        sessions.load(std::memory_order_relaxed),
+        coin_used.load(std::memory_order_relaxed),
+        coin_produced.load(std::memory_order_relaxed)
+      };
+    }
+};
@@ -0,0 +1,28 @@
+#include "GatewayStats.h"
+
+#include <mutex>
+
+#include <server/Database.h>
+
+std::atomic<int64_t> GatewayStats::merchants{ 0 };
+std::atomic<int64_t> GatewayStats::sessions{ 0 };
+std::atomic<int64_t> GatewayStats::coin_used{ 0 };
+std::atomic<int64_t> GatewayStats::coin_produced{ 0 };
+
+void GatewayStats::load() {
+  nlohmann::json coin = Database::ledger().get("coin").value_or(nlohmann::json::object());
+  coin_used.store(coin.value("used", 0ll), std::memory_order_relaxed);
+  coin_produced.store(coin.value("produced", 0ll), std::memory_order_relaxed);
+}
+void GatewayStats::coins_changed(int64_t used, int64_t produced) {
+  if (used == 0 && produced == 0)
+    return;
+
+  // Counters and ledger record move together, a later change never gets persisted before an earlier one
+  static std::mutex ledger_mtx;
+  std::lock_guard<std::mutex> lock(ledger_mtx);
+  int64_t total_used = coin_used.fetch_add(used, std::memory_order_relaxed) + used;
+  int64_t total_produced = coin_produced.fetch_add(produced, std::memory_order_relaxed) + produced;
+  if (Database::is_open())
+    Database::ledger().put("coin", { { "used", total_used }, { "produced", total_produced } });
+}
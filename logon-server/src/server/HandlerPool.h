@@ -0,0 +1,77 @@
+#pragma once
+
+#include <BaseApp.h>
+
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <functional>
+#include <unordered_map>
+#include <condition_variable>
+
+class Player;
+
+/**
+ * HandlerPool
+ * Worker threads executing packet handlers away from the ENet service threads.
+ *
+ * Tasks are posted to a strand (one per player). Tasks of the same strand run
+ * one at a time in posting order, tasks of different strands run in parallel,
+ * so a slow handler only delays the peer that triggered it.
+ *
+ * Example usage:
+ * @code
+ * HandlerPool::start(4);
+ * HandlerPool::post(player, [] {
+ *   // Runs after every task previously posted for this player
+ * });
+ * @endcode
+ */
+class HandlerPool {
+  private:
+    struct Strand {
+      std::deque<std::function<void()>> tasks;
+      bool scheduled = false;   /** <- Strand sits in the ready queue or is being run */
+    };
+
+    static std::unordered_map<const void*, Strand> strands;
+    static std::deque<const void*> ready;
+    static std::vector<std::thread> workers;
+    static std::mutex mtx;
+    static std::condition_variable cv;
+    static bool stopping;
+
+  public:
+    /**
+     * Start the worker threads
+     * 
+     * @param amount - Amount of workers, 0 runs every task inline on the posting thread
+     */
+    static void start(size_t amount);
+
+    /**
+     * Stop the workers, tasks that did not start yet are discarded
+     * Discarded retire() tasks leave their Player undeleted, acceptable only at exit.
+     * Call it after the posting threads stopped and before the peers the tasks use are freed
+     */
+    static void stop();
+
+    /**
+     * Queue a task on a strand
+     * 
+     * @param strand - Key of the strand, usually the Player the task works on
+     * @param task - Task to run on a worker
+     */
+    static void post(const void* strand, std::function<void()> task);
+
+    /**
+     * Delete a player once every task already posted for it has finished
+     * 
+     * @param player - Player detached from its peer
+     */
+    static void retire(Player* player);
+
+  private:
+    static void worker();
+};
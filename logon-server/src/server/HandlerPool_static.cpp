@@ -0,0 +1,92 @@
+#include "HandlerPool.h"
+
+#include <player/Player.h>
+#include <utils/ConsoleInterface.h>
+
+std::unordered_map<const void*, HandlerPool::Strand> HandlerPool::strands = {};
+std::deque<const void*> HandlerPool::ready = {};
+std::vector<std::thread> HandlerPool::workers = {};
+std::mutex HandlerPool::mtx;
+std::condition_variable HandlerPool::cv;
+bool HandlerPool::stopping = false;
+
+void HandlerPool::start(size_t amount) {
+  std::lock_guard<std::mutex> lock(mtx);
+  stopping = false;
+  for (size_t i = 0; i < amount; i++)
+    workers.emplace_back(&HandlerPool::worker);
+}
+void HandlerPool::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    stopping = true;
+  }
+  cv.notify_all();
+
+  for (auto& worker : workers) {
+    if (worker.joinable())
+      worker.join();
+  }
+
+  std::lock_guard<std::mutex> lock(mtx);
+  workers.clear();
+  strands.clear();
+  ready.clear();
+}
+void HandlerPool::post(const void* strand, std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!workers.empty()) {
+      Strand& s = strands[strand];
+      s.tasks.emplace_back(std::move(task));
+      if (s.scheduled)
+        return;
+
+      s.scheduled = true;
+      ready.push_back(strand);
+      cv.notify_one();
+      return;
+    }
+  }
+
+  // No worker running, behave like the old inline handlers
+  task();
+}
+void HandlerPool::retire(Player* player) {
+  if (player == nullptr)
+    return;
+
+  post(player, [player] { delete player; });
+}
+void HandlerPool::worker() {
+  std::unique_lock<std::mutex> lock(mtx);
+
+  while (true) {
+    cv.wait(lock, [] { return stopping || !ready.empty(); });
+    if (stopping)
+      return;
+
+    const void* key = ready.front();
+    ready.pop_front();
+
+    Strand& strand = strands[key];
+    std::function<void()> task = std::move(strand.tasks.front());
+    strand.tasks.pop_front();
+
+    lock.unlock();
+    try {
+      task();
+    }
+    catch (const std::exception& e) {
+      print_error("Handler task failed: {}", e.what());
+    }
+    lock.lock();
+
+    // One task per turn, then let other strands run before continuing this one
+    Strand& after = strands[key];
+    if (after.tasks.empty())
+      strands.erase(key);
+    else
+      ready.push_back(key);
+  }
+}
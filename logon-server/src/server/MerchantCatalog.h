@@ -0,0 +1,174 @@
+#pragma once
+
+#include <BaseApp.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+struct ServerColor {
+  int red = 255;
+  int green = 255;
+  int blue = 255;
+  int alpha = 255;
+};
+
+struct Merchant {
+  std::string name;
+  std::string tankIDName;
+  std::string tankIDPass;
+  std::string role;                 /** <- "admin" or "merchant" */
+  std::string servers_key;
+  std::string api_key;
+  int coin = 0;
+  bool hide_servers = false;
+  nlohmann::json raw;               /** <- File content as loaded, unknown fields are written back untouched */
+
+  nlohmann::json to_json() const;
+  static Merchant from_json(const nlohmann::json& data);
+};
+
+struct MerchantServer {
+  std::string name;
+  std::string display_name;
+  std::string host = "127.0.0.1";
+  int port = 17091;
+  long long expired_at = 0;         /** <- Seconds on the steady clock */
+  bool disable = false;
+  bool hide_server = false;
+  bool block_3rd_app = false;
+  ServerColor color;
+  nlohmann::json raw;
+
+  bool expired(TimePoint now) const;
+  // Spend one coin of owner for 30 more days once expired, without coins the server is disabled.
+  // Returns false if the server got disabled
+  bool renew(Merchant& owner, TimePoint now);
+
+  nlohmann::json to_json() const;
+  static MerchantServer from_json(const nlohmann::json& data);
+};
+
+struct ServerList {
+  std::string key;
+  std::vector<MerchantServer> servers;
+  nlohmann::json raw;
+
+  // First server with that name which is not disabled, nullptr if none
+  const MerchantServer* find_enabled(const std::string& name) const;
+  MerchantServer* find_enabled(const std::string& name);
+
+  nlohmann::json to_json() const;
+  static ServerList from_json(const std::string& key, const nlohmann::json& data);
+};
+
+/**
+ * MerchantCatalog
+ * Merchants and their server lists kept in memory, loaded from the Database
+ * tables (or the JSON files under database/merchants/ and database/servers/
+ * when the store is not open).
+ *
+ * Readers take the current snapshot, an immutable map of shared entries, with
+ * one atomic load and never block. Mutations go through a single writer: the
+ * touched merchant and its server list are copied, changed and published as
+ * a new snapshot; only the records that actually changed are persisted.
+ * Readers holding the old snapshot keep a consistent view until they drop it.
+ *
+ * A name found on neither is remembered for MISSING_RECHECK, so logins with an
+ * unknown doorID do not look at the disk under the writer lock every time.
+ *
+ * Example usage:
+ * @code
+ * MerchantCatalog::load();
+ * auto snapshot = MerchantCatalog::snapshot();
+ * if (const Merchant* merchant = snapshot->find_merchant("Gemtopia")) {
+ *   // merchant stays valid as long as snapshot is held
+ * }
+ * MerchantCatalog::update("Gemtopia", [](Merchant& merchant, ServerList& servers) {
+ *   merchant.coin++;
+ *   return true;
+ * });
+ * @endcode
+ */
+class MerchantCatalog {
+  public:
+    struct Snapshot {
+      std::unordered_map<std::string, std::shared_ptr<const Merchant>> merchants;
+      std::unordered_map<std::string, std::shared_ptr<const ServerList>> servers;   /** <- By servers_key */
+
+      const Merchant* find_merchant(const std::string& name) const;
+      const ServerList* find_servers(const std::string& key) const;
+    };
+
+    // Return true if anything changed, false leaves the catalog untouched
+    using Mutation = std::function<bool(Merchant& merchant, ServerList& servers)>;
+
+    // Merchants approved on disk while running show up at most this late
+    static constexpr std::chrono::seconds MISSING_RECHECK = std::chrono::seconds(60);
+    static constexpr size_t MAX_MISSING = 4096;
+
+  private:
+    static std::atomic<std::shared_ptr<const Snapshot>> current;
+    static std::mutex writer_mtx;
+    static std::string base_path;
+    static std::atomic<bool> json_mirror;
+
+    // Unknown merchant name -> when the disk may be checked again
+    static std::shared_mutex missing_mtx;
+    static std::unordered_map<std::string, TimePoint> missing;
+
+  public:
+    /**
+     * Load every merchant and server list, replaces the current snapshot
+     *
+     * @param path - Database directory holding merchants/ and servers/, merchants approved later are read from here
+     * @return Amount of merchants loaded
+     */
+    static size_t load(const std::string& path = "../../../database/");
+
+    /**
+     * Current snapshot, never nullptr
+     */
+    static std::shared_ptr<const Snapshot> snapshot() {
+      return current.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Snapshot containing merchant, a merchant added to the database after load() is read once
+     *
+     * @param merchant - Merchant name
+     * @return Snapshot, find_merchant(merchant) is nullptr if the merchant does not exist
+     */
+    static std::shared_ptr<const Snapshot> acquire(const std::string& merchant);
+
+    /**
+     * Apply a mutation to a merchant and its servers, changed records are persisted in the background
+     *
+     * @param merchant - Merchant name
+     * @param mutation - Called on copies of the merchant and its server list
+     * @return False if the merchant does not exist or nothing changed
+     */
+    static bool update(const std::string& merchant, const Mutation& mutation);
+
+    /**
+     * Also write changed records to the JSON layout through WriteBehind while the store is open
+     */
+    static void set_json_mirror(bool enabled) {
+      json_mirror.store(enabled, std::memory_order_relaxed);
+    }
+
+  private:
+    // Caller holds writer_mtx
+    static std::shared_ptr<const Snapshot> load_merchant(const std::string& merchant);
+    static bool recently_missing(const std::string& merchant);
+    static void remember_missing(const std::string& merchant);
+    // One store append, queued on WriteBehind too without a store or with the JSON mirror on
+    static void persist(const std::string& name, std::shared_ptr<const Merchant> merchant);
+    static void persist(std::shared_ptr<const ServerList> servers);
+};
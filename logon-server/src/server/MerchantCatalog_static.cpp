@@ -0,0 +1,302 @@
+#include "MerchantCatalog.h"
+
+#include <algorithm>
+#include <filesystem>
+
+#include <utils/ConsoleInterface.h>
+#include <utils/FileSystem2.h>
+#include <utils/Utils.h>
+#include <server/WriteBehind.h>
+#include <server/Database.h>
+#include <server/GatewayStats.h>
+
+std::atomic<std::shared_ptr<const MerchantCatalog::Snapshot>> MerchantCatalog::current = std::make_shared<const MerchantCatalog::Snapshot>();
+std::mutex MerchantCatalog::writer_mtx;
+std::string MerchantCatalog::base_path = "../../../database/";
+std::atomic<bool> MerchantCatalog::json_mirror = false;
+std::shared_mutex MerchantCatalog::missing_mtx;
+std::unordered_map<std::string, TimePoint> MerchantCatalog::missing;
+
+nlohmann::json Merchant::to_json() const {
+  nlohmann::json data = raw.is_object() ? raw : nlohmann::json::object();
+  data["name"] = name;
+  data["tankIDName"] = tankIDName;
+  data["tankIDPass"] = tankIDPass;
+  data["role"] = role;
+  data["servers_key"] = servers_key;
+  data["api_key"] = api_key;
+  data["coin"] = coin;
+  data["options"]["hide_servers"] = hide_servers;
+  return data;
+}
+Merchant Merchant::from_json(const nlohmann::json& data) {
+  Merchant merchant;
+  merchant.name = data.value("name", "");
+  merchant.tankIDName = data.value("tankIDName", "");
+  merchant.tankIDPass = data.value("tankIDPass", "");
+  merchant.role = data.value("role", "");
+  merchant.servers_key = data.value("servers_key", "");
+  merchant.api_key = data.value("api_key", "");
+  merchant.coin = data.value("coin", 0);
+  merchant.hide_servers = data.value("options", nlohmann::json::object()).value("hide_servers", false);
+  merchant.raw = data;
+  return merchant;
+}
+
+bool MerchantServer::expired(TimePoint now) const {
+  return TimePoint(std::chrono::seconds(expired_at)) < now;
+}
+bool MerchantServer::renew(Merchant& owner, TimePoint now) {
+  if (!expired(now))
+    return true;
+
+  // Perpanjang durasi
+  if (owner.coin > 0) {
+    owner.coin--;
+    expired_at = std::chrono::duration_cast<std::chrono::seconds>((now + std::chrono::days(30)).time_since_epoch()).count();
+    return true;
+  }
+  disable = true;
+  return false;
+}
+nlohmann::json MerchantServer::to_json() const {
+  nlohmann::json data = raw.is_object() ? raw : nlohmann::json::object();
+  data["name"] = name;
+  data["display_name"] = display_name;
+  data["host"] = host;
+  data["port"] = port;
+  data["expired_at"] = expired_at;
+  data["options"]["disable"] = disable;
+  data["options"]["hide_server"] = hide_server;
+  data["options"]["block_3rd_app"] = block_3rd_app;
+  data["options"]["color"] = { { "red", color.red }, { "green", color.green }, { "blue", color.blue }, { "alpha", color.alpha } };
+  return data;
+}
+MerchantServer MerchantServer::from_json(const nlohmann::json& data) {
+  MerchantServer server;
+  server.name = data.value("name", "NONE");
+  server.display_name = data.value("display_name", "NONE");
+  server.host = data.value("host", "127.0.0.1");
+  server.port = data.value("port", 17091);
+  server.expired_at = data.value("expired_at", 0ll);
+
+  nlohmann::json options = data.value("options", nlohmann::json::object());
+  server.disable = options.value("disable", false);
+  server.hide_server = options.value("hide_server", false);
+  server.block_3rd_app = options.value("block_3rd_app", false);
+
+  nlohmann::json color = options.value("color", nlohmann::json::object());
+  server.color = { color.value("red", 0), color.value("green", 0), color.value("blue", 0), color.value("alpha", 0) };
+  server.raw = data;
+  return server;
+}
+
+const MerchantServer* ServerList::find_enabled(const std::string& name) const {
+  for (const auto& server : servers) {
+    if (!server.disable && server.name == name)
+      return &server;
+  }
+  return nullptr;
+}
+MerchantServer* ServerList::find_enabled(const std::string& name) {
+  return const_cast<MerchantServer*>(static_cast<const ServerList*>(this)->find_enabled(name));
+}
+nlohmann::json ServerList::to_json() const {
+  nlohmann::json data = raw.is_object() ? raw : nlohmann::json::object();
+  data["servers"] = nlohmann::json::array();
+  for (const auto& server : servers)
+    data["servers"].push_back(server.to_json());
+  return data;
+}
+ServerList ServerList::from_json(const std::string& key, const nlohmann::json& data) {
+  ServerList list;
+  list.key = key;
+  if (data.contains("servers") && data["servers"].is_array()) {
+    for (const auto& server : data["servers"])
+      list.servers.push_back(MerchantServer::from_json(server));
+  }
+  list.raw = data;
+  return list;
+}
+
+const Merchant* MerchantCatalog::Snapshot::find_merchant(const std::string& name) const {
+  auto it = merchants.find(name);
+  return it != merchants.end() ? it->second.get() : nullptr;
+}
+const ServerList* MerchantCatalog::Snapshot::find_servers(const std::string& key) const {
+  auto it = servers.find(key);
+  return it != servers.end() ? it->second.get() : nullptr;
+}
+
+size_t MerchantCatalog::load(const std::string& path) {
+  auto snapshot = std::make_shared<Snapshot>();
+
+  if (Database::is_open()) {
+    Database::servers().for_each([&](const std::string& key, const ServerList& servers) {
+      snapshot->servers[key] = std::make_shared<const ServerList>(servers);
+    });
+    Database::merchants().for_each([&](const std::string& name, const Merchant& merchant) {
+      snapshot->merchants[name] = std::make_shared<const Merchant>(merchant);
+    });
+  }
+  else {
+    // No store, straight from the JSON layout
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(path + "servers/", ec)) {
+      if (!entry.is_regular_file() || entry.path().extension() != ".json")
+        continue;
+
+      try {
+        std::string key = entry.path().stem().string();
+        snapshot->servers[key] = std::make_shared<const ServerList>(ServerList::from_json(key, FileSystem2::readJson(entry.path().string())));
+      }
+      catch (const std::exception& e) {
+        print_error("Failed to load servers {}: {}", entry.path().string(), e.what());
+      }
+    }
+    for (const auto& entry : std::filesystem::directory_iterator(path + "merchants/", ec)) {
+      if (!entry.is_regular_file() || entry.path().extension() != ".json")
+        continue;
+
+      try {
+        snapshot->merchants[entry.path().stem().string()] = std::make_shared<const Merchant>(Merchant::from_json(FileSystem2::readJson(entry.path().string())));
+      }
+      catch (const std::exception& e) {
+        print_error("Failed to load merchant {}: {}", entry.path().string(), e.what());
+      }
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(writer_mtx);
+  base_path = path;
+  current.store(snapshot, std::memory_order_release);
+  {
+    std::unique_lock<std::shared_mutex> missing_lock(missing_mtx);
+    missing.clear();
+  }
+  GatewayStats::set_merchants(static_cast<int64_t>(snapshot->merchants.size()));
+  return snapshot->merchants.size();
+}
+std::shared_ptr<const MerchantCatalog::Snapshot> MerchantCatalog::acquire(const std::string& merchant) {
+  std::shared_ptr<const Snapshot> snapshot = MerchantCatalog::snapshot();
+  if (snapshot->find_merchant(merchant) != nullptr)
+    return snapshot;
+
+  if (recently_missing(merchant))
+    return snapshot;
+
+  std::lock_guard<std::mutex> lock(writer_mtx);
+  snapshot = load_merchant(merchant);
+  if (snapshot->find_merchant(merchant) == nullptr)
+    remember_missing(merchant);
+  return snapshot;
+}
+bool MerchantCatalog::recently_missing(const std::string& merchant) {
+  std::shared_lock<std::shared_mutex> lock(missing_mtx);
+  auto it = missing.find(merchant);
+  return it != missing.end() && current_time() < it->second;
+}
+void MerchantCatalog::remember_missing(const std::string& merchant) {
+  TimePoint now = current_time();
+  std::unique_lock<std::shared_mutex> lock(missing_mtx);
+
+  // Random doorIDs must not grow the map without bound
+  if (missing.size() >= MAX_MISSING) {
+    std::erase_if(missing, [&](const auto& entry) { return entry.second <= now; });
+    if (missing.size() >= MAX_MISSING)
+      missing.clear();
+  }
+  missing[merchant] = now + MISSING_RECHECK;
+}
+bool MerchantCatalog::update(const std::string& merchant, const Mutation& mutation) {
+  std::lock_guard<std::mutex> lock(writer_mtx);
+  std::shared_ptr<const Snapshot> snapshot = load_merchant(merchant);
+  const Merchant* source = snapshot->find_merchant(merchant);
+  if (source == nullptr)
+    return false;
+
+  Merchant mData = *source;
+  const ServerList* sources = snapshot->find_servers(source->servers_key);
+  ServerList sData = sources != nullptr ? *sources : ServerList::from_json(source->servers_key, { { "merchant", merchant } });
+  if (!mutation(mData, sData))
+    return false;
+
+  // Dirty tracking, records the mutation left as they were are not written again
+  bool merchant_dirty = mData.to_json() != source->to_json();
+  bool servers_dirty = sources == nullptr || sData.to_json() != sources->to_json();
+  if (!merchant_dirty && !servers_dirty)
+    return false;
+
+  int64_t coins = static_cast<int64_t>(mData.coin) - source->coin;
+  GatewayStats::coins_changed(coins < 0 ? -coins : 0, coins > 0 ? coins : 0);
+
+  auto next = std::make_shared<Snapshot>(*snapshot);
+  auto merchant_record = std::make_shared<const Merchant>(std::move(mData));
+  auto servers_record = std::make_shared<const ServerList>(std::move(sData));
+  next->merchants[merchant] = merchant_record;
+  next->servers[servers_record->key] = servers_record;
+  current.store(next, std::memory_order_release);
+
+  if (merchant_dirty)
+    persist(merchant, merchant_record);
+  if (servers_dirty)
+    persist(servers_record);
+  return true;
+}
+std::shared_ptr<const MerchantCatalog::Snapshot> MerchantCatalog::load_merchant(const std::string& merchant) {
+  std::shared_ptr<const Snapshot> snapshot = current.load(std::memory_order_acquire);
+  if (snapshot->find_merchant(merchant) != nullptr || merchant.empty() || !Utils::isPathSafeText(merchant))
+    return snapshot;
+
+  // Merchant approved while running
+  std::string path = base_path + "merchants/" + merchant + ".json";
+  if (!std::filesystem::exists(path))
+    return snapshot;
+
+  auto next = std::make_shared<Snapshot>(*snapshot);
+  int coin = 0;
+  try {
+    auto mData = std::make_shared<const Merchant>(Merchant::from_json(FileSystem2::readJson(path)));
+    std::string servers_path = base_path + "servers/" + mData->servers_key + ".json";
+    if (!next->find_servers(mData->servers_key) && std::filesystem::exists(servers_path)) {
+      auto sData = std::make_shared<const ServerList>(ServerList::from_json(mData->servers_key, FileSystem2::readJson(servers_path)));
+      if (Database::is_open())
+        persist(sData);
+      next->servers[mData->servers_key] = std::move(sData);
+    }
+    if (Database::is_open())
+      persist(merchant, mData);
+    coin = mData->coin;
+    next->merchants[merchant] = std::move(mData);
+  }
+  catch (const std::exception& e) {
+    print_error("Failed to load merchant {}: {}", merchant, e.what());
+    return snapshot;
+  }
+
+  current.store(next, std::memory_order_release);
+  // An approved merchant enters with its starting balance, those coins count as produced
+  GatewayStats::merchants_changed(1);
+  GatewayStats::coins_changed(0, std::max(coin, 0));
+  return next;
+}
+void MerchantCatalog::persist(const std::string& name, std::shared_ptr<const Merchant> merchant) {
+  if (Database::is_open()) {
+    Database::merchants().put(name, *merchant);
+    if (!json_mirror.load(std::memory_order_relaxed))
+      return;
+  }
+  WriteBehind::write(base_path + "merchants/" + name + ".json", [merchant] {
+    return merchant->to_json().dump(4);
+  });
+}
+void MerchantCatalog::persist(std::shared_ptr<const ServerList> servers) {
+  if (Database::is_open()) {
+    Database::servers().put(servers->key, *servers);
+    if (!json_mirror.load(std::memory_order_relaxed))
+      return;
+  }
+  WriteBehind::write(base_path + "servers/" + servers->key + ".json", [servers] {
+    return servers->to_json().dump(4);
+  });
+}
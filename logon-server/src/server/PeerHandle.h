@@ -0,0 +1,83 @@
+#pragma once
+
+#include <BaseApp.h>
+
+#include <enet/enet.h>
+
+#include <utils/MPSCQueue.h>
+#include <packet/ConstPacket.h>
+
+enum eOutboundFlags : enet_uint8 {
+  OUTBOUND_SEND = 0,
+  OUTBOUND_DISCONNECT = 1 << 0,   /** <- enet_peer_disconnect_later once everything before it is sent */
+  OUTBOUND_CONSTANT = 1 << 1,     /** <- Send the shard's copy of constant, packet is unused */
+  OUTBOUND_BROADCAST = 1 << 2,    /** <- Send packet to every matching peer of the shard, index and generation are unused */
+};
+
+/**
+ * Outgoing work for a peer, consumed by the shard thread owning the peer
+ */
+struct OutboundPacket {
+  enet_uint16 index = 0;
+  enet_uint32 generation = 0;
+  ENetPacket* packet = nullptr;
+  enet_uint8 channel = 0;
+  enet_uint8 flags = OUTBOUND_SEND;
+  ConstPacketId constant = ConstPacketId::COUNT;
+};
+
+using OutboundQueue = MPSCQueue<OutboundPacket>;
+
+/**
+ * PeerHandle
+ * Thread-safe reference to a connected peer.
+ *
+ * A handle names a peer slot of one shard plus the generation of the
+ * connection it was issued for. The shard bumps the generation on every
+ * connect and disconnect, so sends through a handle of a peer that left (or
+ * whose slot was reused) are dropped instead of reaching the wrong player.
+ *
+ * Example usage:
+ * @code
+ * PeerHandle handle = pClient->get_handle();
+ * handle.send(enet_packet_create(data, len, ENET_PACKET_FLAG_RELIABLE)); // Any thread
+ * handle.send(ConstPacketId::HELLO);                                        // Shared, nothing allocated
+ * handle.disconnect();
+ * @endcode
+ */
+struct PeerHandle {
+  OutboundQueue* queue = nullptr;
+  enet_uint16 index = 0;
+  enet_uint32 generation = 0;
+
+  bool is_valid() const { return queue != nullptr; }
+
+  /**
+   * Queue a packet, the handle takes ownership of it
+   */
+  void send(ENetPacket* packet, enet_uint8 channel = 0) const {
+    if (!is_valid()) {
+      enet_packet_destroy(packet);
+      return;
+    }
+    queue->push({ index, generation, packet, channel, OUTBOUND_SEND });
+  }
+
+  /**
+   * Queue a pre-encoded packet, the shard thread sends its own copy of it
+   */
+  void send(ConstPacketId constant, enet_uint8 channel = 0) const {
+    if (!is_valid())
+      return;
+    queue->push({ index, generation, nullptr, channel, OUTBOUND_CONSTANT, constant });
+  }
+
+  /**
+   * Queue a graceful disconnect after the packets already sent through this handle
+   */
+  void disconnect() const {
+    if (!is_valid())
+      return;
+    queue->push({ index, generation, nullptr, 0, OUTBOUND_DISCONNECT });
+  }
+};
@@ -0,0 +1,99 @@
+#include "PeerValidator.h"
+
+#include <nlohmann/json.hpp>
+
+#include <utils/Curl.h>
+
+PeerValidator::PeerValidator(size_t workers) {
+  // curl_global_init is not guaranteed to be thread-safe, make sure the
+  // first call happens before any worker creates a Curl handle
+  curl_global_init(CURL_GLOBAL_DEFAULT);
+
+  if (workers == 0)
+    workers = 1;
+
+  m_workers.reserve(workers);
+  for (size_t i = 0; i < workers; i++)
+    m_workers.emplace_back(&PeerValidator::worker, this);
+}
+PeerValidator::~PeerValidator() {
+  {
+    std::lock_guard<std::mutex> lock(m_jobs_mtx);
+    m_stopping = true;
+    m_jobs.clear();
+  }
+  m_jobs_cv.notify_all();
+
+  for (auto& worker : m_workers) {
+    if (worker.joinable())
+      worker.join();
+  }
+
+  curl_global_cleanup();
+}
+void PeerValidator::submit(ENetPeer* peer, const std::string& ip) {
+  {
+    std::lock_guard<std::mutex> lock(m_jobs_mtx);
+    m_jobs.push_back({ peer, peer->connectID, peer->address.host, ip });
+  }
+  m_jobs_cv.notify_one();
+}
+size_t PeerValidator::poll(std::vector<ValidationResult>& out) {
+  std::lock_guard<std::mutex> lock(m_results_mtx);
+  size_t count = m_results.size();
+  if (count == 0)
+    return 0;
+
+  out.insert(out.end(), m_results.begin(), m_results.end());
+  m_results.clear();
+  return count;
+}
+TypedCache<enet_uint32, bool>& PeerValidator::known_addresses() {
+  static TypedCache<enet_uint32, bool> addresses(KNOWN_ADDRESS_CAPACITY);
+  return addresses;
+}
+void PeerValidator::worker() {
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(m_jobs_mtx);
+      m_jobs_cv.wait(lock, [&] { return m_stopping || !m_jobs.empty(); });
+      if (m_stopping)
+        return;
+
+      job = std::move(m_jobs.front());
+      m_jobs.pop_front();
+    }
+
+    ValidationResult result = lookup(job);
+
+    std::lock_guard<std::mutex> lock(m_results_mtx);
+    m_results.emplace_back(result);
+  }
+}
+ValidationResult PeerValidator::lookup(const Job& job) {
+  ValidationResult result;
+  result.peer = job.peer;
+  result.connect_id = job.connect_id;
+
+  Curl curl;
+  curl.setUrl("http://localhost:8080/check-ip/" + job.ip);
+  curl.setTimeout((known_addresses().exists(job.host) ? 2 : 5));
+  curl.setSSLVerification(false);
+
+  if (!curl.perform())
+    return result;
+
+  try {
+    nlohmann::json response = nlohmann::json::parse(curl.getResponseData());
+    if ((response.contains("status") && response["status"] == true) || (response.contains("is_vps") && response["is_vpn"] == true) || (response.contains("is_vps") && response["is_vps"] == true) || (response.contains("is_proxy") && response["is_proxy"] == true)) {
+      result.blocked = true;
+    }
+    if (response.contains("presentence") && response["presentence"] >= 85) {
+      result.warned = true;
+    }
+  }
+  catch (...) {}
+
+  return result;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <BaseApp.h>
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <enet/enet.h>
+
+#include <utils/TypedCache.h>
+
+/**
+ * Outcome of an IP-reputation lookup, handed back to the service thread
+ */
+struct ValidationResult {
+  ENetPeer* peer = nullptr;
+  enet_uint32 connect_id = 0;   /** <- Used to detect a peer slot reused by another connection */
+  bool blocked = false;         /** <- Prohibited address / third-party app, peer must be dropped */
+  bool warned = false;          /** <- Suspicious address, peer may continue */
+};
+
+/**
+ * PeerValidator
+ * Runs the check-ip lookups of freshly connected peers on a pool of worker
+ * threads so ENET_EVENT_TYPE_CONNECT never blocks the service thread.
+ *
+ * Only the worker threads talk to the check-ip API; the peer itself is never
+ * touched outside the service thread. Finished lookups are collected with
+ * poll() and applied by the owner of the ENetHost.
+ *
+ * Example usage:
+ * @code
+ * PeerValidator validator(8);
+ * validator.submit(peer, "127.0.0.1");
+ *
+ * std::vector<ValidationResult> results;
+ * validator.poll(results); // On the service thread
+ * @endcode
+ */
+class PeerValidator {
+private:
+  struct Job {
+    ENetPeer* peer;
+    enet_uint32 connect_id;
+    enet_uint32 host;
+    std::string ip;
+  };
+
+  static constexpr size_t KNOWN_ADDRESS_CAPACITY = 65536;
+
+  std::vector<std::thread> m_workers;
+  std::deque<Job> m_jobs;
+  std::mutex m_jobs_mtx;
+  std::condition_variable m_jobs_cv;
+  bool m_stopping = false;
+
+  std::vector<ValidationResult> m_results;
+  std::mutex m_results_mtx;
+
+public:
+  /**
+   * Constructor for PeerValidator
+   *
+   * @param workers - Amount of lookups allowed to be in flight at the same time
+   */
+  PeerValidator(size_t workers);
+
+  /**
+   * Destructor for PeerValidator
+   * Stops the workers, pending lookups are discarded
+   */
+  ~PeerValidator();
+
+  /**
+   * Queue a lookup for a peer, returns immediately
+   *
+   * @param peer - Connected peer, only used as an identifier by the workers
+   * @param ip - Peer IPv4 as string
+   */
+  void submit(ENetPeer* peer, const std::string& ip);
+
+  /**
+   * Move every finished lookup into out
+   *
+   * @return Amount of results appended
+   */
+  size_t poll(std::vector<ValidationResult>& out);
+
+  /**
+   * Addresses that logged in recently, keyed by peer->address.host
+   * Their lookup gets a shorter timeout, the API answered them moments ago
+   *
+   * Example usage:
+   * @code
+   * PeerValidator::known_addresses().set(peer->address.host, true, std::chrono::seconds(300));
+   * @endcode
+   */
+  static TypedCache<enet_uint32, bool>& known_addresses();
+
+private:
+  void worker();
+  static ValidationResult lookup(const Job& job);
+};
@@ -0,0 +1,86 @@
+#include "RedirectTicket.h"
+
+#include <chrono>
+#include <cstring>
+
+#include <utils/Hmac.h>
+#include <utils/Utils.h>
+
+namespace {
+  template<typename T>
+  void write(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+  void write(std::string& out, const std::string& value) {
+    write(out, static_cast<uint8_t>(value.size()));
+    out.append(value);
+  }
+
+  template<typename T>
+  bool read(std::string_view& in, T& value) {
+    if (in.size() < sizeof(T))
+      return false;
+    std::memcpy(&value, in.data(), sizeof(T));
+    in.remove_prefix(sizeof(T));
+    return true;
+  }
+  bool read(std::string_view& in, std::string& value) {
+    uint8_t size = 0;
+    if (!read(in, size) || in.size() < size)
+      return false;
+    value.assign(in.substr(0, size));
+    in.remove_prefix(size);
+    return true;
+  }
+
+  Hmac::Digest mac_of(std::string_view secret, std::string_view payload) {
+    std::string signed_data(RedirectTicket::TAG);
+    signed_data.append(payload);
+    return Hmac::sign(secret, signed_data);
+  }
+}
+
+std::string RedirectTicket::encode(std::string_view secret) const {
+  // Longer fields would not fit their u8 length, names and hosts are far shorter
+  std::string payload;
+  write(payload, VERSION);
+  write(payload, static_cast<uint64_t>(expires_at));
+  write(payload, port);
+  write(payload, merchant.substr(0, 255));
+  write(payload, name.substr(0, 255));
+  write(payload, host.substr(0, 255));
+
+  Hmac::Digest mac = mac_of(secret, payload);
+  payload.append(reinterpret_cast<const char*>(mac.data()), MAC_SIZE);
+  return std::string(TAG) + Utils::base64_encode(reinterpret_cast<const unsigned char*>(payload.data()), static_cast<unsigned int>(payload.size()));
+}
+bool RedirectTicket::is_ticket(std::string_view token) {
+  return token.size() > TAG.size() && token.substr(0, TAG.size()) == TAG;
+}
+std::optional<RedirectTicket> RedirectTicket::verify(std::string_view token, std::string_view secret) {
+  if (!is_ticket(token) || secret.empty())
+    return std::nullopt;
+
+  std::string decoded = Utils::base64_decode(std::string(token.substr(TAG.size())));
+  if (decoded.size() <= MAC_SIZE)
+    return std::nullopt;
+
+  std::string_view payload(decoded.data(), decoded.size() - MAC_SIZE);
+  Hmac::Digest mac = mac_of(secret, payload);
+  if (!Hmac::equal(mac.data(), reinterpret_cast<const uint8_t*>(decoded.data() + payload.size()), MAC_SIZE))
+    return std::nullopt;
+
+  RedirectTicket ticket;
+  uint8_t version = 0;
+  uint64_t expires_at = 0;
+  std::string_view in = payload;
+  if (!read(in, version) || version != VERSION || !read(in, expires_at) || !read(in, ticket.port) ||
+    !read(in, ticket.merchant) || !read(in, ticket.name) || !read(in, ticket.host))
+    return std::nullopt;
+
+  ticket.expires_at = static_cast<long long>(expires_at);
+  long long now = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+  if (ticket.expires_at != 0 && ticket.expires_at < now)
+    return std::nullopt;
+  return ticket;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <BaseApp.h>
+
+#include <string>
+#include <optional>
+#include <string_view>
+
+/**
+ * RedirectTicket
+ * Stateless replacement of a stored session: the redirect target signed with HMAC-SHA256.
+ *
+ * The ticket travels to the client in the auth field of OnSendToServer and
+ * comes back as UUIDToken on the next login. Verifying it is one MAC over
+ * the payload, the gateway keeps nothing per player.
+ *
+ * Token: "GT1" + base64 of u8 version, u64 expiry (Unix seconds, 0 = never), u16 port,
+ * then merchant, name and host each as u8 length + bytes, followed by the
+ * first MAC_SIZE bytes of HMAC-SHA256(secret, "GT1" + everything before).
+ *
+ * Example usage:
+ * @code
+ * RedirectTicket ticket{ "Gemtopia", "MY SERVER", "127.0.0.1", 17091, expiry };
+ * std::string token = ticket.encode(secret);
+ * if (std::optional<RedirectTicket> back = RedirectTicket::verify(token, secret)) {
+ *   // back->host, back->port
+ * }
+ * @endcode
+ */
+struct RedirectTicket {
+  static constexpr std::string_view TAG = "GT1";
+  static constexpr uint8_t VERSION = 1;
+  static constexpr size_t MAC_SIZE = 16;
+
+  std::string merchant;
+  std::string name;
+  std::string host;
+  uint16_t port = 0;
+  long long expires_at = 0;     /** <- Unix seconds, 0 = never expires */
+
+  std::string encode(std::string_view secret) const;
+
+  // Cheap check before decoding, tokens of old clients are plain UUIDs
+  static bool is_ticket(std::string_view token);
+
+  /**
+   * Decode a ticket and check its MAC and expiry
+   *
+   * @return nullopt if the token is no ticket, forged, truncated or expired
+   */
+  static std::optional<RedirectTicket> verify(std::string_view token, std::string_view secret);
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <BaseApp.h>
+
+#include <string>
+#include <vector>
+#include <shared_mutex>
+#include <unordered_map>
+
+/**
+ * RegistrationIndex
+ * Merchant registrations per IPv4 address, held in memory.
+ *
+ * Keyed by the 32-bit address as in ENetAddress::host (PlayerCredentials::address),
+ * so the per-login check is one hash lookup without building a string. Loaded
+ * once from the registrations table of the Database; every registration is
+ * written back as one record of its address, appended to the store log.
+ *
+ * Example usage:
+ * @code
+ * RegistrationIndex::load();
+ * if (RegistrationIndex::count(credentials.address) < RegistrationIndex::MAX_PER_ADDRESS) {
+ *   // Show "Join merchant"
+ * }
+ * RegistrationIndex::add(credentials.address, "Gemtopia");
+ * @endcode
+ */
+class RegistrationIndex {
+  public:
+    static constexpr size_t MAX_PER_ADDRESS = 3;
+
+  private:
+    static std::unordered_map<uint32_t, std::vector<std::string>> registrations;
+    static std::shared_mutex mtx;
+
+  public:
+    /**
+     * Fill the index from the Database
+     *
+     * @return Amount of addresses loaded
+     */
+    static size_t load();
+
+    /**
+     * Amount of merchants registered from an address
+     */
+    static size_t count(uint32_t address);
+
+    /**
+     * Record a merchant registered from an address
+     *
+     * @return False if the address already reached MAX_PER_ADDRESS
+     */
+    static bool add(uint32_t address, const std::string& merchant);
+
+    // Dotted form used as key of the Database table and in registered.json
+    static std::string format_address(uint32_t address);
+    static bool parse_address(const std::string& text, uint32_t& address);
+};
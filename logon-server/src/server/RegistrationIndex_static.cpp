@@ -0,0 +1,70 @@
+#include "RegistrationIndex.h"
+
+#include <charconv>
+#include <cstring>
+#include <mutex>
+
+#include <fmt/format.h>
+
+#include <server/Database.h>
+
+std::unordered_map<uint32_t, std::vector<std::string>> RegistrationIndex::registrations = {};
+std::shared_mutex RegistrationIndex::mtx;
+
+size_t RegistrationIndex::load() {
+  std::unordered_map<uint32_t, std::vector<std::string>> loaded;
+  Database::registrations().for_each([&](const std::string& key, const std::vector<std::string>& names) {
+    uint32_t address = 0;
+    if (parse_address(key, address))
+      loaded[address] = names;
+  });
+
+  std::unique_lock<std::shared_mutex> lock(mtx);
+  registrations = std::move(loaded);
+  return registrations.size();
+}
+size_t RegistrationIndex::count(uint32_t address) {
+  std::shared_lock<std::shared_mutex> lock(mtx);
+  auto it = registrations.find(address);
+  return it != registrations.end() ? it->second.size() : 0;
+}
+bool RegistrationIndex::add(uint32_t address, const std::string& merchant) {
+  std::unique_lock<std::shared_mutex> lock(mtx);
+  std::vector<std::string>& names = registrations[address];
+  if (names.size() >= MAX_PER_ADDRESS)
+    return false;
+
+  names.push_back(merchant);
+  Database::registrations().put(format_address(address), names);
+  return true;
+}
+std::string RegistrationIndex::format_address(uint32_t address) {
+  // Network byte order, first octet in the lowest address byte
+  uint8_t octets[4];
+  std::memcpy(octets, &address, sizeof(octets));
+  return fmt::format("{}.{}.{}.{}", octets[0], octets[1], octets[2], octets[3]);
+}
+bool RegistrationIndex::parse_address(const std::string& text, uint32_t& address) {
+  uint8_t octets[4];
+  const char* it = text.data();
+  const char* end = text.data() + text.size();
+  for (int i = 0; i < 4; i++) {
+    if (i > 0) {
+      if (it == end || *it != '.')
+        return false;
+      it++;
+    }
+
+    unsigned int octet = 0;
+    auto result = std::from_chars(it, end, octet);
+    if (result.ec != std::errc() || octet > 255)
+      return false;
+    octets[i] = static_cast<uint8_t>(octet);
+    it = result.ptr;
+  }
+  if (it != end)
+    return false;
+
+  std::memcpy(&address, octets, sizeof(address));
+  return true;
+}
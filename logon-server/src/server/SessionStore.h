@@ -0,0 +1,92 @@
+#pragma once
+
+#include <BaseApp.h>
+
+#include <array>
+#include <string>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include <server/handler/PacketSchema.h>
+
+// Redirect target remembered for a login session, stored as "name=..&host=..&port=..&last_access=.."
+struct Session {
+  std::string name;
+  std::string host;
+  int port = 0;
+  long long last_access = 0;      /** <- Unix seconds */
+
+  PACKET_SCHEMA(Session, name, host, port, last_access)
+
+  std::string encode() const;
+};
+
+/**
+ * SessionStore
+ * Login sessions (UUIDToken -> redirect target) held in memory with a TTL.
+ *
+ * Lookups hit a sharded hash map and never touch the disk. Every change is
+ * mirrored to the sessions table of the Database, whose log compaction keeps
+ * the persisted copy small; load() restores the map from it on start.
+ * Sessions not used for longer than the TTL are dropped on lookup and by
+ * sweep(), which the ENetServer housekeeping posts periodically.
+ *
+ * Example usage:
+ * @code
+ * SessionStore::load(std::chrono::hours(24 * 30));
+ * SessionStore::put(token, { "MY SERVER", "127.0.0.1", 17091 });
+ * if (std::optional<Session> session = SessionStore::find(token)) {
+ *   // Redirect straight to session->host:session->port
+ * }
+ * @endcode
+ */
+class SessionStore {
+  private:
+    static constexpr size_t SHARD_COUNT = 16;
+
+    struct Shard {
+      mutable std::shared_mutex mtx;
+      std::unordered_map<std::string, Session> sessions;
+    };
+
+    static std::array<Shard, SHARD_COUNT> shards;
+    static std::chrono::seconds ttl;
+
+  public:
+    /**
+     * Fill the map from the Database, expired sessions are removed from it
+     *
+     * @param lifetime - Time a session stays valid after its last use
+     * @return Amount of sessions restored
+     */
+    static size_t load(std::chrono::seconds lifetime);
+
+    /**
+     * Session of a token, nullopt if unknown or expired
+     */
+    static std::optional<Session> find(const std::string& token);
+
+    /**
+     * Remember the redirect target of a token, last_access is set to now
+     */
+    static void put(const std::string& token, Session session);
+
+    static void erase(const std::string& token);
+
+    /**
+     * Drop every expired session
+     *
+     * @return Amount of sessions dropped
+     */
+    static size_t sweep();
+
+    static size_t size();
+
+  private:
+    static Shard& shard_of(const std::string& token) {
+      return shards[std::hash<std::string>{}(token) % SHARD_COUNT];
+    }
+    static long long now();
+    static bool expired(const Session& session, long long at);
+};
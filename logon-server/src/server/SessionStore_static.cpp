@@ -0,0 +1,121 @@
+#include "SessionStore.h"
+
+#include <vector>
+#include <mutex>
+#include <fmt/format.h>
+
+#include <server/Database.h>
+#include <server/GatewayStats.h>
+
+// Sessions written before last_access was wall-clock time carry steady_clock seconds, treated as used on load
+static constexpr long long LEGACY_LAST_ACCESS = 1577836800; // 2020-01-01
+
+std::array<SessionStore::Shard, SessionStore::SHARD_COUNT> SessionStore::shards;
+std::chrono::seconds SessionStore::ttl = std::chrono::hours(24 * 30);
+
+std::string Session::encode() const {
+  return fmt::format("name={}&host={}&port={}&last_access={}", name, host, port, last_access);
+}
+
+size_t SessionStore::load(std::chrono::seconds lifetime) {
+  ttl = lifetime;
+  long long at = now();
+  size_t loaded = 0;
+
+  // Copied out first, for_each holds the store lock and put() takes it after the shard lock
+  std::vector<std::pair<std::string, std::string>> records;
+  Database::sessions().for_each([&](const std::string& token, const std::string& param) {
+    records.emplace_back(token, param);
+  });
+
+  for (const auto& [token, param] : records) {
+    Session session = Session::decode_params(param);
+    if (session.last_access < LEGACY_LAST_ACCESS)
+      session.last_access = at;
+    if (expired(session, at)) {
+      Database::sessions().erase(token);
+      continue;
+    }
+
+    Shard& shard = shard_of(token);
+    std::unique_lock<std::shared_mutex> lock(shard.mtx);
+    shard.sessions[token] = std::move(session);
+    loaded++;
+  }
+  GatewayStats::set_sessions(static_cast<int64_t>(loaded));
+  return loaded;
+}
+std::optional<Session> SessionStore::find(const std::string& token) {
+  Shard& shard = shard_of(token);
+  {
+    std::shared_lock<std::shared_mutex> lock(shard.mtx);
+    auto it = shard.sessions.find(token);
+    if (it == shard.sessions.end())
+      return std::nullopt;
+    if (!expired(it->second, now()))
+      return it->second;
+  }
+
+  // Expired, checked again in case the token was just renewed
+  std::unique_lock<std::shared_mutex> lock(shard.mtx);
+  auto it = shard.sessions.find(token);
+  if (it != shard.sessions.end() && !expired(it->second, now()))
+    return it->second;
+  if (it != shard.sessions.end()) {
+    shard.sessions.erase(it);
+    Database::sessions().erase(token);
+    GatewayStats::sessions_changed(-1);
+  }
+  return std::nullopt;
+}
+void SessionStore::put(const std::string& token, Session session) {
+  session.last_access = now();
+
+  // The Database copy changes under the shard lock, both stay in the same order
+  Shard& shard = shard_of(token);
+  std::unique_lock<std::shared_mutex> lock(shard.mtx);
+  Database::sessions().put(token, session.encode());
+  if (shard.sessions.insert_or_assign(token, std::move(session)).second)
+    GatewayStats::sessions_changed(1);
+}
+void SessionStore::erase(const std::string& token) {
+  Shard& shard = shard_of(token);
+  std::unique_lock<std::shared_mutex> lock(shard.mtx);
+  if (shard.sessions.erase(token) != 0) {
+    Database::sessions().erase(token);
+    GatewayStats::sessions_changed(-1);
+  }
+}
+size_t SessionStore::sweep() {
+  long long at = now();
+  size_t dropped = 0;
+
+  for (Shard& shard : shards) {
+    std::unique_lock<std::shared_mutex> lock(shard.mtx);
+    for (auto it = shard.sessions.begin(); it != shard.sessions.end(); ) {
+      if (!expired(it->second, at)) {
+        it++;
+        continue;
+      }
+      Database::sessions().erase(it->first);
+      it = shard.sessions.erase(it);
+      dropped++;
+    }
+  }
+  GatewayStats::sessions_changed(-static_cast<int64_t>(dropped));
+  return dropped;
+}
+size_t SessionStore::size() {
+  size_t total = 0;
+  for (const Shard& shard : shards) {
+    std::shared_lock<std::shared_mutex> lock(shard.mtx);
+    total += shard.sessions.size();
+  }
+  return total;
+}
+long long SessionStore::now() {
+  return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+bool SessionStore::expired(const Session& session, long long at) {
+  return ttl.count() > 0 && session.last_access + ttl.count() < at;
+}
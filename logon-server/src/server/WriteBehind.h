@@ -0,0 +1,80 @@
+#pragma once
+
+#include <BaseApp.h>
+
+#include <string>
+#include <thread>
+#include <mutex>
+#include <functional>
+#include <unordered_map>
+#include <condition_variable>
+
+/**
+ * WriteBehind
+ * Database files written by a background flusher instead of the handler thread.
+ *
+ * A write marks the file dirty together with a serializer. Writes to the same
+ * file within the window replace the pending serializer, so a burst of
+ * changes becomes one write. Every flush writes all due files to temp files,
+ * syncs them in one batch and renames them over the originals, a crash never
+ * leaves a half written file behind. Skipping unchanged records is up to the
+ * caller, MerchantCatalog only writes what its dirty tracking flagged.
+ *
+ * Example usage:
+ * @code
+ * WriteBehind::start(std::chrono::milliseconds(1000));
+ * WriteBehind::write("../../../database/merchants/Gemtopia.json", [merchant] {
+ *   return merchant->to_json().dump(4);   // Runs on the flusher
+ * });
+ * WriteBehind::stop();                     // Flushes everything still pending
+ * @endcode
+ */
+class WriteBehind {
+  public:
+    using Serializer = std::function<std::string()>;
+
+  private:
+    struct Pending {
+      Serializer serialize;
+      TimePoint due;
+    };
+
+    static std::unordered_map<std::string, Pending> pending;
+    static std::chrono::milliseconds window;
+    static std::thread flusher;
+    static std::mutex mtx;
+    static std::condition_variable cv;
+    static bool stopping;
+
+  public:
+    /**
+     * Start the flusher thread
+     *
+     * @param delay - Coalescing window, 0 writes synchronously on the calling thread
+     */
+    static void start(std::chrono::milliseconds delay);
+
+    /**
+     * Stop the flusher, every pending file is written before it returns
+     */
+    static void stop();
+
+    /**
+     * Mark a file dirty
+     *
+     * @param path - File to write
+     * @param serialize - Produces the file content, called once when the file is flushed
+     */
+    static void write(const std::string& path, Serializer serialize);
+
+    /**
+     * Write every pending file now
+     */
+    static void flush();
+
+  private:
+    static void run();
+    // Caller holds mtx, taken entries are removed from pending
+    static std::unordered_map<std::string, Serializer> take(TimePoint until);
+    static void commit(std::unordered_map<std::string, Serializer>& batch);
+};
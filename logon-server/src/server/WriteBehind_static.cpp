@@ -0,0 +1,184 @@
+#include "WriteBehind.h"
+
+#include <cstdio>
+#include <algorithm>
+#include <vector>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <utils/ConsoleInterface.h>
+
+std::unordered_map<std::string, WriteBehind::Pending> WriteBehind::pending = {};
+std::chrono::milliseconds WriteBehind::window{ 0 };
+std::thread WriteBehind::flusher;
+std::mutex WriteBehind::mtx;
+std::condition_variable WriteBehind::cv;
+bool WriteBehind::stopping = false;
+
+// Taking and committing a batch happen under one lock, an older batch of a file never lands after a newer one
+static std::mutex commit_mtx;
+
+static bool sync_file(std::FILE* file) {
+  if (std::fflush(file) != 0)
+    return false;
+#ifdef _WIN32
+  return _commit(_fileno(file)) == 0;
+#else
+  return fsync(fileno(file)) == 0;
+#endif
+}
+
+void WriteBehind::start(std::chrono::milliseconds delay) {
+  std::lock_guard<std::mutex> lock(mtx);
+  window = delay;
+  stopping = false;
+  if (window.count() > 0 && !flusher.joinable())
+    flusher = std::thread(&WriteBehind::run);
+}
+void WriteBehind::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    stopping = true;
+  }
+  cv.notify_all();
+
+  if (flusher.joinable())
+    flusher.join();
+
+  flush();
+}
+void WriteBehind::write(const std::string& path, Serializer serialize) {
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!stopping && window.count() > 0) {
+      auto it = pending.find(path);
+      if (it != pending.end()) {
+        // Keep the first deadline, later writes ride along
+        it->second.serialize = std::move(serialize);
+        return;
+      }
+
+      pending.emplace(path, Pending{ std::move(serialize), current_time() + window });
+      cv.notify_one();
+      return;
+    }
+  }
+
+  // No flusher running, write through
+  std::lock_guard<std::mutex> commit_lock(commit_mtx);
+  std::unordered_map<std::string, Serializer> batch;
+  batch.emplace(path, std::move(serialize));
+  commit(batch);
+}
+void WriteBehind::flush() {
+  std::lock_guard<std::mutex> commit_lock(commit_mtx);
+  std::unordered_map<std::string, Serializer> batch;
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    batch = take(TimePoint::max());
+  }
+  commit(batch);
+}
+void WriteBehind::run() {
+  std::unique_lock<std::mutex> lock(mtx);
+
+  while (!stopping) {
+    if (pending.empty()) {
+      cv.wait(lock, [] { return stopping || !pending.empty(); });
+      continue;
+    }
+
+    TimePoint next = TimePoint::max();
+    for (const auto& [path, entry] : pending)
+      next = std::min(next, entry.due);
+    if (current_time() < next) {
+      cv.wait_until(lock, next);
+      continue;
+    }
+
+    lock.unlock();
+    {
+      std::lock_guard<std::mutex> commit_lock(commit_mtx);
+      std::unordered_map<std::string, Serializer> batch;
+      {
+        std::lock_guard<std::mutex> relock(mtx);
+        batch = take(current_time());
+      }
+      commit(batch);
+    }
+    lock.lock();
+  }
+}
+std::unordered_map<std::string, WriteBehind::Serializer> WriteBehind::take(TimePoint until) {
+  std::unordered_map<std::string, Serializer> batch;
+  for (auto it = pending.begin(); it != pending.end(); ) {
+    if (it->second.due > until) {
+      it++;
+      continue;
+    }
+
+    batch.emplace(it->first, std::move(it->second.serialize));
+    it = pending.erase(it);
+  }
+  return batch;
+}
+void WriteBehind::commit(std::unordered_map<std::string, Serializer>& batch) {
+  struct Staged {
+    std::string path;
+    std::string temp;
+  };
+  std::vector<Staged> staged;
+
+  // Write every temp file first, then sync and rename them together
+  std::vector<std::FILE*> files;
+  for (auto& [path, serialize] : batch) {
+    std::string content;
+    try {
+      content = serialize();
+    }
+    catch (const std::exception& e) {
+      print_error("Failed to serialize {}: {}", path, e.what());
+      continue;
+    }
+
+    std::error_code ec;
+    std::filesystem::path target(path);
+    if (target.has_parent_path())
+      std::filesystem::create_directories(target.parent_path(), ec);
+
+    std::string temp = path + ".tmp";
+    std::FILE* file = std::fopen(temp.c_str(), "wb");
+    if (file == nullptr || std::fwrite(content.data(), 1, content.size(), file) != content.size()) {
+      print_error("Failed to write {}", temp);
+      if (file != nullptr)
+        std::fclose(file);
+      continue;
+    }
+
+    files.push_back(file);
+    staged.push_back({ path, std::move(temp) });
+  }
+
+  for (size_t i = 0; i < files.size(); i++) {
+    if (!sync_file(files[i])) {
+      print_error("Failed to sync {}", staged[i].temp);
+      staged[i].path.clear();
+    }
+    std::fclose(files[i]);
+  }
+
+  for (const auto& entry : staged) {
+    if (entry.path.empty())
+      continue;
+
+    std::error_code ec;
+    std::filesystem::rename(entry.temp, entry.path, ec);
+    if (ec)
+      print_error("Failed to replace {}: {}", entry.path, ec.message());
+  }
+}
@@ -1,13 +1,115 @@
 #pragma once
 
-#include <functional>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
 #include <enet/enet.h>
 
 #include <player/RoleDef.h>
 #include <SDK/Proton/TextScanner.h>
 
+using HandlerFn = bool (*)(ENetPeer* peer, TextScanner* pkt);
+
 struct FnBody {
+  std::string_view key;
   PlayerRole required_role = PlayerRole::NONE;
   PlayerAttribute required_attribute = PlayerAttribute::NONE;
-  std::function<bool(ENetPeer* peer, TextScanner* pkt)> Fn = NULL;
-};
\ No newline at end of file
+  HandlerFn Fn = nullptr;
+  bool restricted = false;              /** <- Set by HandlerTable, the player's roles have to be checked */
+};
+
+/**
+ * HandlerTable
+ * Handler keys -> FnBody through a perfect hash built at compile time.
+ *
+ * The constructor searches for a seed that puts every key in its own slot,
+ * a lookup is one hash of the key, one slot and one string compare. Tables
+ * are meant to be defined constexpr, a duplicate key then fails the build.
+ *
+ * constexpr HandlerTable handle = {
+ *   { "exit", PlayerRole::NONE, PlayerAttribute::NONE, &exit },
+ * };
+ * if (const FnBody* fn = handle.find(key)) fn->Fn(peer, pkt);
+ */
+class HandlerTable {
+  public:
+  static constexpr size_t C_MAX_SLOTS = 128;
+  static constexpr uint32_t C_SEEDS_PER_SIZE = 256;
+
+  constexpr HandlerTable(std::initializer_list<FnBody> handlers) {
+    if (handlers.size() > C_MAX_SLOTS / 2)
+      throw std::logic_error("HandlerTable: too many handlers");
+
+    size_t slots = 2;
+    while (slots < handlers.size() * 2) slots <<= 1;
+
+    // Grow the table when no seed works, keeps the compile-time search short
+    for (; slots <= C_MAX_SLOTS; slots <<= 1) {
+      for (uint32_t seed = 1; seed <= C_SEEDS_PER_SIZE; seed++) {
+        if (place(handlers, seed, slots - 1)) {
+          m_size = handlers.size();
+          return;
+        }
+      }
+    }
+    throw std::logic_error("HandlerTable: no perfect hash found, duplicate key?");
+  }
+
+  constexpr const FnBody* find(std::string_view key) const {
+    const FnBody& body = m_slots[hash(key, m_seed) & m_mask];
+    return body.Fn != nullptr && body.key == key ? &body : nullptr;
+  }
+
+  constexpr size_t size() const { return m_size; }
+
+  private:
+  std::array<FnBody, C_MAX_SLOTS> m_slots{};
+  uint32_t m_seed = 0;
+  uint32_t m_mask = 0;
+  size_t m_size = 0;
+
+  // Length plus the first and last 8 bytes of the key; only registered keys need distinct slots,
+  // anything else is rejected by the compare in find()
+  static constexpr uint32_t hash(std::string_view key, uint32_t seed) {
+    size_t n = key.size() < 8 ? key.size() : 8;
+    uint64_t head = load(key, 0, n);
+    uint64_t tail = load(key, key.size() - n, n);
+    uint64_t h = head * 0x9E3779B97F4A7C15ull ^ (tail + key.size()) * 0xC4CEB9FE1A85EC53ull ^ seed;
+    // Finalizer, spreads every input bit over the low bits used as slot index
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    return static_cast<uint32_t>(h);
+  }
+
+  static constexpr uint64_t load(std::string_view key, size_t pos, size_t n) {
+    uint64_t value = 0;
+    if (std::is_constant_evaluated() || n < 8) {
+      for (size_t i = 0; i < n; i++)
+        value |= static_cast<uint64_t>(static_cast<uint8_t>(key[pos + i])) << (8 * i);
+    }
+    else {
+      std::memcpy(&value, key.data() + pos, 8);
+    }
+    return value;
+  }
+
+  constexpr bool place(std::initializer_list<FnBody> handlers, uint32_t seed, size_t mask) {
+    m_slots = {};
+    for (const FnBody& body : handlers) {
+      FnBody& slot = m_slots[hash(body.key, seed) & mask];
+      if (slot.Fn != nullptr)
+        return false;
+
+      slot = body;
+      slot.restricted = body.required_role != PlayerRole::NONE || body.required_attribute != PlayerAttribute::NONE;
+    }
+    m_seed = seed;
+    m_mask = static_cast<uint32_t>(mask);
+    return true;
+  }
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <BaseApp.h>
+
+#include <enet/enet.h>
+
+class Player;
+
+/**
+ * HandlerContext
+ * State of a handler running on a HandlerPool worker.
+ *
+ * The peer belongs to its shard thread, so while a context is bound to the
+ * current thread the handler reads its player from here instead of
+ * peer->data. Outgoing packets go through the player's PeerHandle.
+ */
+struct HandlerContext {
+  ENetPeer* peer = nullptr;
+  Player* player = nullptr;
+  bool disconnect = false;              /** <- Handler asked to drop the peer */
+
+  /**
+   * Context bound to this thread, nullptr on the service threads
+   */
+  static HandlerContext*& current() {
+    static thread_local HandlerContext* ctx = nullptr;
+    return ctx;
+  }
+};
@@ -20,7 +20,7 @@
 
 class NetMessageGameMessageHandler {
   private:
-  static std::unordered_map<std::string, FnBody> handle;
+  static const HandlerTable handle;
 
   public:
   static int init();
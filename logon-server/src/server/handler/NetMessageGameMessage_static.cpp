@@ -3,25 +3,27 @@
 #include <GlobalVar.h>
 
 #include <utils/SystemUtils.h>
+#include <server/GatewayStats.h>
 #include <SDK/Builders/DialogBuilder.h>
 
-std::unordered_map<std::string, FnBody> NetMessageGameMessageHandler::handle = {};
+constexpr HandlerTable NetMessageGameMessageHandler::handle = {
+  { "exit", PlayerRole::NONE, PlayerAttribute::NONE, &exit },
+  { "quit_to_exit", PlayerRole::NONE, PlayerAttribute::NONE, &quit_to_exit },
+  { "join_request", PlayerRole::NONE, PlayerAttribute::NONE, &join_request },
+  { "world_button", PlayerRole::NONE, PlayerAttribute::NONE, &join_request },
+};
 
 int NetMessageGameMessageHandler::init() {
-  handle["exit"] = { PlayerRole::NONE, PlayerAttribute::NONE, &exit};
-  handle["quit_to_exit"] = { PlayerRole::NONE, PlayerAttribute::NONE, &quit_to_exit};
-  handle["join_request"] = { PlayerRole::NONE, PlayerAttribute::NONE, &join_request};
-  handle["world_button"] = { PlayerRole::NONE, PlayerAttribute::NONE, &join_request};
-
-  return handle.size();
+  return static_cast<int>(handle.size());
 }
 
 void NetMessageGameMessageHandler::execute(ENetPeer* peer, TextScanner* pkt) {
   if (!Utils::PeerValidation(peer))
     return;
 
-  std::string key = pkt->GetParmStringFromLine(0,0);
-  if (pkt->GetLineCount() == 1 || "action" == key) key = pkt->GetParmStringFromLine(0,1);
+  // Views into the packet, no copies on the dispatch path
+  std::string_view key = pkt->GetParmViewFromLine(0,0);
+  if (pkt->GetLineCount() == 1 || "action" == key) key = pkt->GetParmViewFromLine(0,1);
 
   // Securityyyyh anjay
   if (!pClient->tData.contains("ltoken"))
@@ -30,30 +32,29 @@ void NetMessageGameMessageHandler::execute(ENetPeer* peer, TextScanner* pkt) {
     return;
   }
 
-  const auto& it = handle.find(key);
-  if (it != handle.end()) {
-    RoleManager roles = pClient->get_roles();
-    PlayerCredentials credentials = pClient->get_credentials();
-
-    bool has_required_role = roles.has_role(it->second.required_role);
-    bool has_required_attribute = roles.has_attribute(it->second.required_attribute);
-
-    if (has_required_role && has_required_attribute) {
-      bool response = true;
-      try {
-        response = it->second.Fn(peer, pkt);
-      }
-      catch (const std::runtime_error& e) {
-        print_error("Error when player with {}:{}({}) executing {}", credentials.IPv4, peer->address.port, credentials.tankIDName, key);
-        response = true;
-      }
-
-      if (response) {
-        // ....
-      }
-      else {
-        // Bisa dipake buat debug
-      }
+  const FnBody* fn = handle.find(key);
+  if (fn != nullptr) {
+    if (fn->restricted) {
+      RoleManager roles = pClient->get_roles();
+      if (!roles.has_role(fn->required_role) || !roles.has_attribute(fn->required_attribute))
+        return;
+    }
+
+    bool response = true;
+    try {
+      response = fn->Fn(peer, pkt);
+    }
+    catch (const std::runtime_error& e) {
+      PlayerCredentials credentials = pClient->get_credentials();
+      print_error("Error when player with {}:{}({}) executing {}", credentials.IPv4, peer->address.port, credentials.tankIDName, fn->key);
+      response = true;
+    }
+
+    if (response) {
+      // ....
+    }
+    else {
+      // Bisa dipake buat debug
     }
 
     return;
@@ -88,30 +89,22 @@ bool NetMessageGameMessageHandler::join_request(ENetPeer* peer, TextScanner* pkt
     if (!pRole.is_have_parent_role(PlayerRole::MERCHANT))
       return 1;
 
-    if (!pClient->tData.contains("merchant") && !pClient->tData.contains("servers"))
-      return 1;
-
     std::string merchant = pClient->tData["ltoken"]["merchant_name"].get<std::string>();
+    std::shared_ptr<const MerchantCatalog::Snapshot> catalog = MerchantCatalog::snapshot();
+    const Merchant* mData = catalog->find_merchant(merchant);
+    if (mData == nullptr)
+      return 1;
 
-    if (buttonClicked == "my_profile") {
-      Utils::merchant_profile(peer, pClient->tData);
-
-      goto syncData;
-    }
+    if (buttonClicked == "my_profile")
+      Utils::merchant_profile(peer, *mData, catalog->find_servers(mData->servers_key));
 
     return 0;
-
-    syncData:
-      FileSystem2::writeJson(databaseDir + merchant + ".json", pClient->tData["merchant"]);
-      return 0;
   }
   else if (buttonClicked == "control_panel") {
     if (!pRole.is_have_parent_role(PlayerRole::ADMIN))
       return 1;
 
-    int merchants = FileSystem2::countFiles(databaseDir + "merchants/");
-    int sessions = FileSystem2::countFiles(databaseDir + "sessions/");
-    nlohmann::json transactions = FileSystem2::readJson(databaseDir + "transactions.json");
+    GatewayStats::Counters stats = GatewayStats::get();
     auto mem = SystemUtils::getMemoryUsage();
     auto cpu = SystemUtils::getCPUUsage();
     auto ping = SystemUtils::pingHost(DataManager::get_server_config().server_ip);
@@ -122,10 +115,10 @@ bool NetMessageGameMessageHandler::join_request(ENetPeer* peer, TextScanner* pkt
       ->AddSmallText("Here you can view all registered merchants and monitor all servers owned by them.")
       ->AddSpacer(eDialogElementSizes::SMALL)
       ->AddLabel(eDialogElementSizes::SMALL, "`wGateway statistics:", eDialogElementDirections::LEFT)
-      ->AddSmallText(fmt::format("Merchant registered:\t\t `2{}", Utils::format_number(merchants)))
-      ->AddSmallText(fmt::format("Session saved:\t\t `2{}", Utils::format_number(sessions)))
-      ->AddSmallText(fmt::format("Coin used:\t\t `2{}", Utils::format_number(transactions["coin"]["used"].get<int>())))
-      ->AddSmallText(fmt::format("Coin produced:\t\t `2{}", Utils::format_number(transactions["coin"]["produced"].get<int>())))
+      ->AddSmallText(fmt::format("Merchant registered:\t\t `2{}", Utils::format_number(stats.merchants)))
+      ->AddSmallText(fmt::format("Session saved:\t\t `2{}", Utils::format_number(stats.sessions)))
+      ->AddSmallText(fmt::format("Coin used:\t\t `2{}", Utils::format_number(stats.coin_used)))
+      ->AddSmallText(fmt::format("Coin produced:\t\t `2{}", Utils::format_number(stats.coin_produced)))
       ->AddSpacer(eDialogElementSizes::SMALL)
       ->AddLabel(eDialogElementSizes::SMALL, "`wServer statistics:", eDialogElementDirections::LEFT)
       ->AddSmallText(fmt::format("Memory usage:\t\t `2{}%", mem.usage_percent))
@@ -17,10 +17,58 @@
 #include <server/DataManager.h>
 
 #include "FunctionDef.h"
+#include "PacketSchema.h"
+
+struct LoginPacket {
+  std::string_view tankIDName;
+  std::string_view tankIDPass;
+  std::string_view UUIDToken;
+  std::string_view doorID;
+  std::string_view mac;
+  std::string_view gid;
+  std::string_view fz;
+  std::string_view token;
+  ePlatformType platformID{};
+
+  PACKET_SCHEMA(LoginPacket, tankIDName, tankIDPass, UUIDToken, doorID, mac, gid, fz, token, platformID)
+};
+
+struct JoinServerPacket {
+  std::string_view param;
+  std::string_view buttonClicked;
+  std::string_view options_display_name;
+  std::string_view options_name;
+  std::string_view options_host;
+  uint32_t options_port = 0;
+  std::string_view options_color;
+  bool options_hide_server = false;
+  bool options_block_3rd_app = false;
+  bool options_disable = false;
+
+  PACKET_SCHEMA(JoinServerPacket, param, buttonClicked, options_display_name, options_name, options_host, options_port,
+    options_color, options_hide_server, options_block_3rd_app, options_disable)
+};
+
+// Button param of a server in the world offers, "name=..&host=..&port=..&block_3rd_app=.."
+struct ServerParams {
+  std::string name;
+  std::string host;
+  int port = 0;
+
+  PACKET_SCHEMA(ServerParams, name, host, port)
+};
+
+struct JoinMerchantPacket {
+  std::string name;
+  std::string tankIDName;
+  std::string tankIDPass;
+
+  PACKET_SCHEMA(JoinMerchantPacket, name, tankIDName, tankIDPass)
+};
 
 class NetMessageGenericTextHandler {
   private:
-  static std::unordered_map<std::string, FnBody> handle;
+  static const HandlerTable handle;
 
   public:
   static int init();
@@ -31,4 +79,7 @@ class NetMessageGenericTextHandler {
   static bool player_login(ENetPeer* peer, TextScanner* pkt);
   static bool join_server(ENetPeer* peer, TextScanner* pkt);
   static bool join_merchant(ENetPeer* peer, TextScanner* pkt);
+
+  // Redirect to target, edit carries the merchant's server options of a join_server dialog
+  static bool connect_server(ENetPeer* peer, const ServerParams& target, JoinServerPacket* edit = nullptr, TextScanner* pkt = nullptr);
 };
\ No newline at end of file
@@ -1,28 +1,33 @@
 #include "NetMessageGenericText.h"
 
-#include <utils/CacheManager.h>
+#include <server/PeerValidator.h>
+#include <server/Database.h>
+#include <server/SessionStore.h>
+#include <server/RedirectTicket.h>
+#include <server/RegistrationIndex.h>
 #include <utils/KeyGenerator.h>
 #include <GlobalVar.h>
 
-std::unordered_map<std::string, FnBody> NetMessageGenericTextHandler::handle = {};
+constexpr HandlerTable NetMessageGenericTextHandler::handle = {
+  { "ltoken", PlayerRole::NONE, PlayerAttribute::NONE, &ltoken },
+  { "tankIDName", PlayerRole::NONE, PlayerAttribute::NONE, &player_login },
+  { "join_server", PlayerRole::NONE, PlayerAttribute::NONE, &join_server },
+  { "join_merchant", PlayerRole::NONE, PlayerAttribute::NONE, &join_merchant },
+};
 
 int NetMessageGenericTextHandler::init() {
-  handle["ltoken"] = { PlayerRole::NONE, PlayerAttribute::NONE, &ltoken};
-  handle["tankIDName"] = { PlayerRole::NONE, PlayerAttribute::NONE, &player_login};
-  handle["join_server"] = { PlayerRole::NONE, PlayerAttribute::NONE, &join_server};
-  handle["join_merchant"] = { PlayerRole::NONE, PlayerAttribute::NONE, &join_merchant};
-
-  return handle.size();
+  return static_cast<int>(handle.size());
 }
 
 void NetMessageGenericTextHandler::execute(ENetPeer* peer, TextScanner* pkt) {
   if (!Utils::PeerValidation(peer))
     return;
 
-  std::string key = pkt->GetParmStringFromLine(0,0);
-  if (key == "protocol") key = pkt->GetParmStringFromLine(1,0);
-  else if (pkt->GetLineCount() == 1) key = pkt->GetParmStringFromLine(0,1);
-  else if (pkt->GetParmString("dialog_name", 1) != "") key = pkt->GetParmString("dialog_name", 1);
+  // Views into the packet, no copies on the dispatch path
+  std::string_view key = pkt->GetParmViewFromLine(0,0);
+  if (key == "protocol") key = pkt->GetParmViewFromLine(1,0);
+  else if (pkt->GetLineCount() == 1) key = pkt->GetParmViewFromLine(0,1);
+  else if (std::string_view dialog_name = pkt->GetParmView("dialog_name", 1); !dialog_name.empty()) key = dialog_name;
 
   // Securityyyyh anjay
   if (key != "ltoken" && key != "tankIDName" && !pClient->tData.contains("ltoken"))
@@ -31,31 +36,30 @@ void NetMessageGenericTextHandler::execute(ENetPeer* peer, TextScanner* pkt) {
     return;
   }
 
-  const auto& it = handle.find(key);
-  if (it != handle.end()) {
-    RoleManager roles = pClient->get_roles();
-    PlayerCredentials credentials = pClient->get_credentials();
-
-    bool has_required_role = roles.has_role(it->second.required_role);
-    bool has_required_attribute = roles.has_attribute(it->second.required_attribute);
+  const FnBody* fn = handle.find(key);
+  if (fn != nullptr) {
+    if (fn->restricted) {
+      RoleManager roles = pClient->get_roles();
+      if (!roles.has_role(fn->required_role) || !roles.has_attribute(fn->required_attribute))
+        return;
+    }
 
-    if (has_required_role && has_required_attribute) {
-      bool response = true;
-      try {
-        response = it->second.Fn(peer, pkt);
-      }
-      catch (const std::runtime_error& e) {
-        VariantList::OnConsoleMessage(peer, e.what());
-        print_error("Error when player with {}:{}({}) executing {}", credentials.IPv4, peer->address.port, credentials.tankIDName, key);
-        response = true;
-      }
+    bool response = true;
+    try {
+      response = fn->Fn(peer, pkt);
+    }
+    catch (const std::runtime_error& e) {
+      PlayerCredentials credentials = pClient->get_credentials();
+      VariantList::OnConsoleMessage(peer, e.what());
+      print_error("Error when player with {}:{}({}) executing {}", credentials.IPv4, peer->address.port, credentials.tankIDName, fn->key);
+      response = true;
+    }
 
-      if (response) {
-        // ....
-      }
-      else {
-        // Bisa dipake buat debug
-      }
+    if (response) {
+      // ....
+    }
+    else {
+      // Bisa dipake buat debug
     }
 
     return;
@@ -71,35 +75,31 @@ bool NetMessageGenericTextHandler::join_merchant(ENetPeer* peer, TextScanner* pk
   if (crd.tankIDName + crd.tankIDPass != "")
     return 1;
 
-  std::string name = pkt->GetParmString("name", 1);
-  std::string tankIDName = pkt->GetParmString("tankIDName", 1);
-  std::string tankIDPass = pkt->GetParmString("tankIDPass", 1);
+  JoinMerchantPacket packet = JoinMerchantPacket::decode(pkt);
+  std::string name = Utils::sanitizePathText(packet.name);
+  std::string& tankIDName = packet.tankIDName;
+  std::string& tankIDPass = packet.tankIDPass;
   std::string apiKey = KeyGenerator::generateAPIKey();
-  name = Utils::sanitizePathText(name);
 
-  if (std::filesystem::exists(databaseDir + "pending/merchants/" + name + ".json")) {
-    VariantList::OnDialogRequest(peer, Utils::DialogJoinMerchant(name, tankIDName, tankIDPass, "`4Merchant is already in pre-register list!").AddTextbox(std::string(146, ' '))->Build());
+  // The store is authoritative for merchants, acquire() also picks up one approved on disk while running.
+  // The catalog only serializes on its own writer lock, the database mutex below guards the pending files
+  if (MerchantCatalog::acquire(name)->find_merchant(name) != nullptr) {
+    VariantList::OnDialogRequest(peer, Utils::DialogJoinMerchant(name, tankIDName, tankIDPass, "`4Merchant is already registered!").AddTextbox(std::string(146, ' '))->Build());
     return 1;
   }
-  if (std::filesystem::exists(databaseDir + "merchants/" + name + ".json")) {
-    VariantList::OnDialogRequest(peer, Utils::DialogJoinMerchant(name, tankIDName, tankIDPass, "`4Merchant is already registered!").AddTextbox(std::string(146, ' '))->Build());
+
+  std::lock_guard<std::recursive_mutex> lock(DataManager::get_database_mutex());
+  if (std::filesystem::exists(databaseDir + "pending/merchants/" + name + ".json")) {
+    VariantList::OnDialogRequest(peer, Utils::DialogJoinMerchant(name, tankIDName, tankIDPass, "`4Merchant is already in pre-register list!").AddTextbox(std::string(146, ' '))->Build());
     return 1;
   }
 
   nlohmann::json data = FileSystem2::readJson(databaseDir + "pending/merchants/example.json");
-  nlohmann::json reg = FileSystem2::readJson(databaseDir + "registered.json");
-  std::vector<std::string> regs = {};
-  
-  if (reg.contains(crd.IPv4))
-    regs = reg[crd.IPv4].get<std::vector<std::string>>();
   
   VariantList::OnRequestWorldSelectMenu(peer, Utils::generate_world_offers(pClient));
 
-  if (regs.size() > 2)
+  if (RegistrationIndex::count(crd.address) >= RegistrationIndex::MAX_PER_ADDRESS)
     return 1;
-  
-  regs.emplace_back(name);
-  reg[crd.IPv4] = regs;
 
   data["name"] = name;
   data["tankIDName"] = tankIDName;
@@ -109,129 +109,116 @@ bool NetMessageGenericTextHandler::join_merchant(ENetPeer* peer, TextScanner* pk
   data["coin"] = 1;
 
   FileSystem2::writeJson(databaseDir + "pending/merchants/" + name + ".json", data);
-  FileSystem2::writeJson(databaseDir + "registered.json", reg);
+  RegistrationIndex::add(crd.address, name);
   VariantList::OnConsoleMessage(peer, "`2You have successfully registered as a merchant. Please wait up to 48 hours for confirmation from our admin.");
 
   return 0;
 }
 bool NetMessageGenericTextHandler::join_server(ENetPeer* peer, TextScanner* pkt) {
-  RoleManager roles = pClient->get_roles();
-  std::string param = pkt->GetParmString("param", 1);
-  if (param == "")
+  JoinServerPacket packet = JoinServerPacket::decode(pkt);
+  if (packet.param.empty())
     return 1;
 
-  std::string base_path = "../../../database/";
-  std::string name = Utils::param_get_value("name", param);
-  std::string host = Utils::param_get_value("host", param);
-  std::string port = Utils::param_get_value("port", param);
-  std::string block_3rd_app = Utils::param_get_value("block_3rd_app", param);
+  return connect_server(peer, ServerParams::decode_params(packet.param), &packet, pkt);
+}
+bool NetMessageGenericTextHandler::connect_server(ENetPeer* peer, const ServerParams& target, JoinServerPacket* edit, TextScanner* pkt) {
+  RoleManager roles = pClient->get_roles();
+  const std::string& name = target.name;
   std::string session = pClient->tData["ltoken"]["_session"].get<std::string>();
   std::string merchant = pClient->tData["ltoken"]["merchant_name"].get<std::string>();
   bool detected = pClient->tData["using_3rd_app"]["status"].get<bool>();
   bool founded = false;
-  int mCoin = 0;
+  // Where the player is sent, read from the catalog so a forged param never reaches a ticket or session
+  ServerParams redirect;
 
   if (detected && !roles.is_have_parent_role(PlayerRole::MERCHANT))
     throw std::runtime_error("The system has detected suspicious behavior from your account. This server does not allow abnormal player activity.");
 
   // Fetch merchant data
-  if (!std::filesystem::exists(base_path + "merchants/" + merchant + ".json")) 
+  std::shared_ptr<const MerchantCatalog::Snapshot> catalog = MerchantCatalog::acquire(merchant);
+  const Merchant* mData = catalog->find_merchant(merchant);
+  if (mData == nullptr)
     throw std::runtime_error(fmt::format("This merchant ({}) are not affiliated with us!", merchant));
 
-  nlohmann::json mData = FileSystem2::readJson(base_path + "merchants/" + merchant + ".json");
-  mCoin = mData["coin"].get<int>();
-
-  if (std::filesystem::exists(base_path + "servers/" + mData["servers_key"].get<std::string>() + ".json"))  {
-    nlohmann::json sData = FileSystem2::readJson(base_path + "servers/" + mData["servers_key"].get<std::string>() + ".json");
-
-    if (sData.contains("servers") && sData["servers"].is_array()) {
-      auto& servers = sData["servers"];
-      
-      int i = -1;
-      for (auto& server : servers) {
-        i++;
-
-        // Check if expired 
-        if (server["options"]["disable"].get<bool>())
-          continue;
-        if (server["name"].get<std::string>() != name)
-          continue;
-
-        if (roles.is_have_parent_role(PlayerRole::MERCHANT)) {
-          std::string display_name_ = pkt->GetParmString("options_display_name", 1);
-          if (display_name_ != "") server["display_name"] = display_name_;
-          std::string name_ = pkt->GetParmString("options_name", 1);
-          if (name_ != "") server["name"] = name_;
-          std::string host_ = pkt->GetParmString("options_host", 1);
-          if (host_ != "") server["host"] = host_;
-          uint32_t port_ = pkt->GetParmUInt("options_port", 1);
-          if (port_ != 0) server["port"] = port_;
-          std::vector<std::string> color = Utils::split(",", pkt->GetParmString("options_color", 1));
-          if (color.size() > 3) {
-            server["options"]["color"]["red"] = std::atoi(color.at(0).c_str());
-            server["options"]["color"]["green"] = std::atoi(color.at(1).c_str());
-            server["options"]["color"]["blue"] = std::atoi(color.at(2).c_str());
-            server["options"]["color"]["alpha"] = std::atoi(color.at(3).c_str());
-          }
-          bool options_hide_server = pkt->GetParmInt("options_hide_server", 1);
-          server["options"]["hide_server"] = options_hide_server;
-          bool block_3rd_app_ = pkt->GetParmInt("options_block_3rd_app", 1);
-          server["options"]["block_3rd_app"] = block_3rd_app_;
-          bool options_disable = pkt->GetParmInt("options_disable", 1);
-          server["options"]["disable"] = options_disable;
-
-          std::string buttonClicked = pkt->GetParmString("buttonClicked", 1);
-          bool refresh = false;
-          if (buttonClicked == "apply") {
-            pkt->Replace("buttonClicked", "amboyyyy");
-            refresh = true;
-          }
-          if (buttonClicked == "options_delete") {
-            servers.erase(i);
-            refresh = true;
-          }
-          if (refresh) {
-            FileSystem2::writeJson(base_path + "servers/" + mData["servers_key"].get<std::string>() + ".json", sData);
-            try {
-              std::string ctx = Utils::generate_world_offers(pClient);
-              VariantList::OnRequestWorldSelectMenu(peer, ctx);
-            }
-            catch (const std::runtime_error& e) {
-              VariantList::OnConsoleMessage(peer, fmt::format("`4Error`w: {}", e.what()));
-              Utils::disconnect_peer(peer);
-            }
-            break;
-          }
+  const ServerList* sData = catalog->find_servers(mData->servers_key);
+  const MerchantServer* selected = sData != nullptr ? sData->find_enabled(name) : nullptr;
+  bool is_merchant = roles.is_have_parent_role(PlayerRole::MERCHANT) && edit != nullptr;
+
+  // Only merchant edits and expired servers go through the writer
+  if (selected != nullptr && (is_merchant || selected->expired(current_time()))) {
+    bool refresh = false;
+    MerchantCatalog::update(merchant, [&](Merchant& owner, ServerList& servers) {
+      founded = false;
+      refresh = false;
+      MerchantServer* server = servers.find_enabled(name);
+      if (server == nullptr)
+        return false;
+
+      if (is_merchant) {
+        if (!edit->options_display_name.empty()) server->display_name = std::string(edit->options_display_name);
+        if (!edit->options_name.empty()) server->name = std::string(edit->options_name);
+        if (!edit->options_host.empty()) server->host = std::string(edit->options_host);
+        if (edit->options_port != 0) server->port = edit->options_port;
+        std::vector<std::string> color = DelimiterScanner::splitCopy(edit->options_color, ",");
+        if (color.size() > 3) {
+          server->color.red = std::atoi(color.at(0).c_str());
+          server->color.green = std::atoi(color.at(1).c_str());
+          server->color.blue = std::atoi(color.at(2).c_str());
+          server->color.alpha = std::atoi(color.at(3).c_str());
+        }
+        server->hide_server = edit->options_hide_server;
+        server->block_3rd_app = edit->options_block_3rd_app;
+        server->disable = edit->options_disable;
+
+        // Copied, the packet is modified below
+        std::string buttonClicked(edit->buttonClicked);
+        if (buttonClicked == "apply") {
+          pkt->Replace("buttonClicked", "amboyyyy");
+          refresh = true;
         }
-          
-        TimePoint expired_at = std::chrono::steady_clock::time_point(std::chrono::seconds(server["expired_at"].get<long long>()));
-        if (expired_at < current_time()) {
-          // Perpanjang durasi
-          if (mCoin > 0) {
-            mCoin--;
-            expired_at = current_time() + std::chrono::days(30);
-            server["expired_at"] = std::chrono::duration_cast<std::chrono::seconds>(expired_at.time_since_epoch()).count();
-            mData["coin"] = mCoin;
-          }
-          else {
-            server["options"]["disable"] = true;
-            break;
-          }
+        if (buttonClicked == "options_delete") {
+          servers.servers.erase(servers.servers.begin() + (server - servers.servers.data()));
+          refresh = true;
         }
-        founded = true;
-        break;
+        if (refresh)
+          return true;
       }
-    }
 
-    FileSystem2::writeJson(base_path + "servers/" + mData["servers_key"].get<std::string>() + ".json", sData);
-    FileSystem2::writeJson(base_path + "merchants/" + merchant + ".json", mData);
+      founded = server->renew(owner, current_time());
+      redirect = { server->name, server->host, server->port };
+      return true;
+    });
+
+    if (refresh) {
+      try {
+        std::string ctx = Utils::generate_world_offers(pClient);
+        VariantList::OnRequestWorldSelectMenu(peer, ctx);
+      }
+      catch (const std::runtime_error& e) {
+        VariantList::OnConsoleMessage(peer, fmt::format("`4Error`w: {}", e.what()));
+        Utils::disconnect_peer(peer);
+      }
+    }
+  }
+  else if (selected != nullptr) {
+    founded = true;
+    redirect = { selected->name, selected->host, selected->port };
   }
 
   if (founded) {
-    VariantList::OnSendToServer(peer, std::atoi(port.c_str()), host, LoginMode::REDIRECT_LOGIN, session, pClient->get_credentials().tankIDName);
-    param = Utils::split("&last_access=", param)[0];
-    param += "&last_access=" + std::to_string(std::chrono::duration_cast<std::chrono::seconds>(current_time().time_since_epoch()).count());
-    FileSystem2::writeFile(base_path + "sessions/" + session, param);
+    const ServerConfig& config = DataManager::get_server_config();
+    if (config.redirect_tickets) {
+      // Nothing stored, the client brings the target back as its UUIDToken. Same lifetime as a session, 0 = never expires
+      long long expires_at = 0;
+      if (config.session_ttl_days > 0)
+        expires_at = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count() + 24ll * 60 * 60 * config.session_ttl_days;
+      RedirectTicket ticket{ merchant, redirect.name, redirect.host, static_cast<uint16_t>(redirect.port), expires_at };
+      VariantList::OnSendToServer(peer, redirect.port, redirect.host, LoginMode::REDIRECT_LOGIN, session, pClient->get_credentials().tankIDName, "0", ticket.encode(config.ticket_secret));
+    }
+    else {
+      VariantList::OnSendToServer(peer, redirect.port, redirect.host, LoginMode::REDIRECT_LOGIN, session, pClient->get_credentials().tankIDName);
+      SessionStore::put(session, { redirect.name, redirect.host, redirect.port });
+    }
     Utils::disconnect_peer(peer);
 
     return 0;
@@ -242,21 +229,22 @@ bool NetMessageGenericTextHandler::join_server(ENetPeer* peer, TextScanner* pkt)
   return 1;
 }
 bool NetMessageGenericTextHandler::player_login(ENetPeer* peer, TextScanner* pkt) {
-  std::string base_path = "../../../database/";
+  LoginPacket login = LoginPacket::decode(pkt);
   PlayerCredentials data = pClient->get_credentials();
-  data.tankIDName = pkt->GetParmString("tankIDName", 1);
-  data.tankIDPass = pkt->GetParmString("tankIDPass", 1);
+  data.tankIDName = login.tankIDName;
+  data.tankIDPass = login.tankIDPass;
   pClient->set_credentials(data);
-  pClient->tData["ltoken"]["_session"] = pkt->GetParmString("UUIDToken", 1);
-  std::string session = pkt->GetParmString("UUIDToken", 1);
-  pClient->tData["ltoken"]["merchant_name"] = pkt->GetParmString("doorID", 1);
+  std::string session(login.UUIDToken);
+  pClient->tData["ltoken"]["_session"] = session;
+  pClient->tData["ltoken"]["merchant_name"] = std::string(login.doorID);
+  pClient->set_merchant(std::string(login.doorID));
   bool using_3rd_app = false;
 
-  std::string mac = pkt->GetParmString("mac", 1);
-  std::string gid = pkt->GetParmString("gid", 1);
-  ePlatformType platformID = static_cast<ePlatformType>(pkt->GetParmUInt("platformID", 1));
+  std::string mac(login.mac);
+  std::string gid(login.gid);
+  ePlatformType platformID = login.platformID;
 
-  if (!Utils::isValidMACAddress(mac) || ((platformID != ePlatformType::PLATFORM_ID_IOS && platformID != ePlatformType::PLATFORM_ID_OSX && platformID != ePlatformType::PLATFORM_ID_WINDOWS && mac != "02:00:00:00:00:00") || (platformID == ePlatformType::PLATFORM_ID_WINDOWS && !pkt->Contain("fz", 1) && mac != "02:00:00:00:00:00"))) {
+  if (!Utils::isValidMACAddress(mac) || ((platformID != ePlatformType::PLATFORM_ID_IOS && platformID != ePlatformType::PLATFORM_ID_OSX && platformID != ePlatformType::PLATFORM_ID_WINDOWS && mac != "02:00:00:00:00:00") || (platformID == ePlatformType::PLATFORM_ID_WINDOWS && login.fz.empty() && mac != "02:00:00:00:00:00"))) {
     pClient->tData["using_3rd_app"]["reason"] = "Invalid MAC";
     using_3rd_app = true;
   }
@@ -264,7 +252,7 @@ bool NetMessageGenericTextHandler::player_login(ENetPeer* peer, TextScanner* pkt
     pClient->tData["using_3rd_app"]["reason"] = "Invalid requestedName";
     using_3rd_app = true;
   }
-  if (platformID == ePlatformType::PLATFORM_ID_WINDOWS && pkt->Contain("token", 1)) {
+  if (platformID == ePlatformType::PLATFORM_ID_WINDOWS && !login.token.empty()) {
     pClient->tData["using_3rd_app"]["reason"] = "Invalid token";
     using_3rd_app = true;
   }
@@ -276,19 +264,25 @@ bool NetMessageGenericTextHandler::player_login(ENetPeer* peer, TextScanner* pkt
 
   if (using_3rd_app) {
     print_warning("Player with GrowID {} detected using 3rd app: {}", data.tankIDName, pClient->tData["using_3rd_app"]["reason"].get<std::string>());
-    VariantList::OnConsoleMessage(peer, "`9Warning: Our system has detected that you're using a `4third-party application`9. Some servers may deny your access. If you believe this is a mistake, please contact the `omerchant owner`9.");
+    Utils::SendConstPacket(peer, ConstPacketId::THIRD_PARTY_WARNING);
   }
 
   VariantList::SetHasGrowID(peer, 0, data.tankIDName, data.tankIDPass);
 
-  // Use session
-  if (std::filesystem::exists(base_path + "sessions/" + session)) {
-    std::string param = FileSystem2::readFile(base_path + "sessions/" + session);
-    std::string pkt_str = "action|dialog_return\ndialog_name|join_server\nparam|" + param + "|\n";
-    TextScanner pckt(pkt_str.c_str());
+  // Reconnect straight to the server of the previous session, from a ticket or the SessionStore
+  std::optional<ServerParams> last;
+  if (RedirectTicket::is_ticket(session)) {
+    std::optional<RedirectTicket> ticket = RedirectTicket::verify(session, DataManager::get_server_config().ticket_secret);
+    if (ticket && ticket->merchant == login.doorID)
+      last = ServerParams{ ticket->name, ticket->host, ticket->port };
+  }
+  else if (std::optional<Session> stored = SessionStore::find(session)) {
+    last = ServerParams{ stored->name, stored->host, stored->port };
+  }
 
+  if (last) {
     try {
-      if (join_server(peer, &pckt))
+      if (connect_server(peer, *last))
         Utils::disconnect_peer(peer);
     }
     catch (const std::runtime_error& e) {
@@ -320,10 +314,11 @@ bool NetMessageGenericTextHandler::ltoken(ENetPeer* peer, TextScanner* pkt) {
   data.tankIDName = Utils::param_get_value("growId", ltoken_);
   data.tankIDPass = Utils::param_get_value("password", ltoken_);
   pClient->set_credentials(data);
-  CacheManager::setWithTTL(data.IPv4, 1, 60000 * 5);
+  PeerValidator::known_addresses().set(data.address, true, std::chrono::seconds(60000 * 5));
 
   if (merchant == "")
     pClient->tData["ltoken"]["merchant_name"] = "GTPS Gateway", merchant = pClient->tData["ltoken"]["merchant_name"].get<std::string>();
+  pClient->set_merchant(merchant);
   VariantList::OnConsoleMessage(peer, "`oConnected on `w" + merchant + "``.");
 
   const auto& sConfig = DataManager::get_server_config();
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <SDK/Proton/TextScanner.h>
+#include <utils/DelimiterScanner.h>
+
+/**
+ * PacketSchema
+ * Compile-time field descriptors for text packets.
+ *
+ * PACKET_SCHEMA names the members of a struct that are filled from packet
+ * lines of the form "label|value". Decoding walks the packet once and matches
+ * every label against the schema, instead of rescanning it per field:
+ * - std::string_view members point into the packet, copy them before it is
+ *   modified or destroyed. std::string members are copied right away
+ * - Integers, floats and enums are converted with std::from_chars, bools are
+ *   non-zero integers
+ * - The first line carrying a label wins, like TextScanner::GetParmString.
+ *   Missing or malformed fields keep the member's default value
+ *
+ * struct LoginPacket {
+ *   std::string_view tankIDName;
+ *   uint32_t platformID = 0;
+ *
+ *   PACKET_SCHEMA(LoginPacket, tankIDName, platformID)
+ * };
+ *
+ * LoginPacket login = LoginPacket::decode(pkt);
+ */
+#define PACKET_SCHEMA(Type, ...)                                                     \
+  static constexpr std::string_view schema_labels = #__VA_ARGS__;                    \
+  auto schema_members() { return std::tie(__VA_ARGS__); }                            \
+  static Type decode(TextScanner* pkt) {                                             \
+    Type out;                                                                        \
+    PacketSchema::decode(pkt, out);                                                  \
+    return out;                                                                      \
+  }                                                                                  \
+  static Type decode_params(std::string_view text) {                                 \
+    Type out;                                                                        \
+    PacketSchema::decode_params(text, out);                                          \
+    return out;                                                                      \
+  }
+
+namespace PacketSchema {
+  inline void parse(std::string_view value, std::string_view& out) {
+    out = value;
+  }
+
+  inline void parse(std::string_view value, std::string& out) {
+    out.assign(value);
+  }
+
+  inline void parse(std::string_view value, bool& out) {
+    int number = 0;
+    std::from_chars(value.data(), value.data() + value.size(), number);
+    out = number != 0;
+  }
+
+  template<typename T>
+  void parse(std::string_view value, T& out) {
+    if constexpr (std::is_enum_v<T>) {
+      std::underlying_type_t<T> number{};
+      if (std::from_chars(value.data(), value.data() + value.size(), number).ec == std::errc())
+        out = static_cast<T>(number);
+    }
+    else {
+      static_assert(std::is_arithmetic_v<T>, "PacketSchema fields are strings, numbers or enums");
+      std::from_chars(value.data(), value.data() + value.size(), out);
+    }
+  }
+
+  // "tankIDName, tankIDPass, mac" -> { "tankIDName", "tankIDPass", "mac" }
+  template<size_t N>
+  constexpr std::array<std::string_view, N> split_labels(std::string_view list) {
+    std::array<std::string_view, N> labels{};
+    size_t pos = 0;
+    for (size_t i = 0; i < N; i++) {
+      size_t end = list.find(',', pos);
+      std::string_view label = list.substr(pos, end == std::string_view::npos ? std::string_view::npos : end - pos);
+      while (!label.empty() && label.front() == ' ') label.remove_prefix(1);
+      while (!label.empty() && label.back() == ' ') label.remove_suffix(1);
+      labels[i] = label;
+      pos = end + 1;
+    }
+    return labels;
+  }
+
+  template<typename T>
+  using Members = decltype(std::declval<T&>().schema_members());
+
+  template<typename T>
+  inline constexpr size_t field_count = std::tuple_size_v<Members<T>>;
+
+  template<typename T>
+  inline constexpr auto labels = split_labels<field_count<T>>(T::schema_labels);
+
+  // Store value into the member named label, unless an earlier line already did
+  template<typename T, size_t... I>
+  void store(Members<T>& members, std::string_view label, std::string_view value, uint64_t& seen, std::index_sequence<I...>) {
+    ((labels<T>[I] == label
+        ? ((seen & (1ull << I)) == 0 ? (parse(value, std::get<I>(members)), seen |= 1ull << I, true) : true)
+        : false) || ...);
+  }
+
+  /**
+   * Decode "label|value" lines of pkt into out in a single pass
+   */
+  template<typename T>
+  void decode(TextScanner* pkt, T& out) {
+    static_assert(field_count<T> <= 64, "PacketSchema supports up to 64 fields");
+
+    Members<T> members = out.schema_members();
+    uint64_t seen = 0;
+    int count = pkt->GetLineCount();
+    for (int i = 0; i < count; i++) {
+      // Labels were located by the scanner's "\n|" pass, only the value is searched here
+      std::string_view line = pkt->GetLineView(i);
+      std::string_view label = pkt->GetLabelView(i);
+      if (label.size() == line.size())
+        continue;
+
+      std::string_view value = line.substr(label.size() + 1);
+      size_t end = DelimiterScanner::find(value, '|');
+      if (end != std::string_view::npos)
+        value = value.substr(0, end);
+
+      store<T>(members, label, value, seen, std::make_index_sequence<field_count<T>>());
+    }
+  }
+
+  /**
+   * Decode a "key=value&key=value" string (dialog button params, ltoken) into out in a single pass
+   */
+  template<typename T>
+  void decode_params(std::string_view text, T& out) {
+    static_assert(field_count<T> <= 64, "PacketSchema supports up to 64 fields");
+
+    Members<T> members = out.schema_members();
+    uint64_t seen = 0;
+    DelimiterScanner::forEachSpan(text, "&", [&](std::string_view entry) {
+      size_t eq = DelimiterScanner::find(entry, '=');
+      if (eq != std::string_view::npos)
+        store<T>(members, entry.substr(0, eq), entry.substr(eq + 1), seen, std::make_index_sequence<field_count<T>>());
+    });
+  }
+}
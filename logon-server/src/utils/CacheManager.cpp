@@ -1,304 +1,539 @@
 ﻿#include "CacheManager.h"
 
+#include <algorithm>
+
+#include "MappedFile.h"
+#include "SnapshotIO.h"
+
+namespace {
+    constexpr uint32_t SNAPSHOT_MAGIC = 0x53435747;     // "GWCS"
+    constexpr uint32_t SNAPSHOT_VERSION = 1;
+}
+
 // Static member definitions
-std::unordered_map<std::string, std::unique_ptr<CacheManager::CacheEntry>> CacheManager::cache_;
-std::mutex CacheManager::mutex_;
-size_t CacheManager::hits_ = 0;
-size_t CacheManager::misses_ = 0;
+std::array<CacheManager::Shard, CacheManager::SHARD_COUNT> CacheManager::shards_;
+std::vector<CacheManager::Namespace> CacheManager::namespaces_ = { { "", 0, CacheManager::EvictionPolicy::LRU } };
+std::shared_mutex CacheManager::namespacesMutex_;
+std::atomic<size_t> CacheManager::memoryBudget_{ 0 };
 
 // CREATE operations
-void CacheManager::set(const std::string& key, int value) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    cache_[key] = std::make_unique<CacheEntry>(CacheValue(value));
+void CacheManager::set(std::string_view key, int value) {
+    store(key, std::make_unique<CacheEntry>(CacheValue(value)));
 }
 
-void CacheManager::set(const std::string& key, long long value) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    cache_[key] = std::make_unique<CacheEntry>(CacheValue(value));
+void CacheManager::set(std::string_view key, long long value) {
+    store(key, std::make_unique<CacheEntry>(CacheValue(value)));
 }
 
-void CacheManager::set(const std::string& key, float value) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    cache_[key] = std::make_unique<CacheEntry>(CacheValue(value));
+void CacheManager::set(std::string_view key, float value) {
+    store(key, std::make_unique<CacheEntry>(CacheValue(value)));
 }
 
-void CacheManager::set(const std::string& key, double value) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    cache_[key] = std::make_unique<CacheEntry>(CacheValue(value));
+void CacheManager::set(std::string_view key, double value) {
+    store(key, std::make_unique<CacheEntry>(CacheValue(value)));
 }
 
-void CacheManager::set(const std::string& key, bool value) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    cache_[key] = std::make_unique<CacheEntry>(CacheValue(value));
+void CacheManager::set(std::string_view key, bool value) {
+    store(key, std::make_unique<CacheEntry>(CacheValue(value)));
 }
 
-void CacheManager::set(const std::string& key, const std::string& value) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    cache_[key] = std::make_unique<CacheEntry>(CacheValue(value));
+void CacheManager::set(std::string_view key, const std::string& value) {
+    store(key, std::make_unique<CacheEntry>(CacheValue(value)));
 }
 
-void CacheManager::set(const std::string& key, const std::vector<uint8_t>& value) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    cache_[key] = std::make_unique<CacheEntry>(CacheValue(value));
+void CacheManager::set(std::string_view key, const std::vector<uint8_t>& value) {
+    store(key, std::make_unique<CacheEntry>(CacheValue(value)));
 }
 
-void CacheManager::setBits(const std::string& key, const std::bitset<64>& value) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    cache_[key] = std::make_unique<CacheEntry>(CacheValue(value));
+void CacheManager::setBits(std::string_view key, const std::bitset<64>& value) {
+    store(key, std::make_unique<CacheEntry>(CacheValue(value)));
 }
 
 // Template implementation for TTL
 template<typename T>
-void CacheManager::setWithTTLImpl(const std::string& key, const T& value, int ttlSeconds) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    cache_[key] = std::make_unique<CacheEntry>(
+void CacheManager::setWithTTLImpl(std::string_view key, const T& value, int ttlSeconds) {
+    store(key, std::make_unique<CacheEntry>(
         CacheValue(value),
         std::chrono::seconds(ttlSeconds)
-    );
+    ));
 }
 
 // Explicit template instantiations
-template void CacheManager::setWithTTLImpl<int>(const std::string&, const int&, int);
-template void CacheManager::setWithTTLImpl<long long>(const std::string&, const long long&, int);
-template void CacheManager::setWithTTLImpl<float>(const std::string&, const float&, int);
-template void CacheManager::setWithTTLImpl<double>(const std::string&, const double&, int);
-template void CacheManager::setWithTTLImpl<bool>(const std::string&, const bool&, int);
-template void CacheManager::setWithTTLImpl<std::string>(const std::string&, const std::string&, int);
-template void CacheManager::setWithTTLImpl<std::vector<uint8_t>>(const std::string&, const std::vector<uint8_t>&, int);
-template void CacheManager::setWithTTLImpl<std::bitset<64>>(const std::string&, const std::bitset<64>&, int);
+template void CacheManager::setWithTTLImpl<int>(std::string_view, const int&, int);
+template void CacheManager::setWithTTLImpl<long long>(std::string_view, const long long&, int);
+template void CacheManager::setWithTTLImpl<float>(std::string_view, const float&, int);
+template void CacheManager::setWithTTLImpl<double>(std::string_view, const double&, int);
+template void CacheManager::setWithTTLImpl<bool>(std::string_view, const bool&, int);
+template void CacheManager::setWithTTLImpl<std::string>(std::string_view, const std::string&, int);
+template void CacheManager::setWithTTLImpl<std::vector<uint8_t>>(std::string_view, const std::vector<uint8_t>&, int);
+template void CacheManager::setWithTTLImpl<std::bitset<64>>(std::string_view, const std::bitset<64>&, int);
 
 // READ operations
-int CacheManager::getInt(const std::string& key, int defaultValue) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = cache_.find(key);
-    if (it != cache_.end() && !isExpired(it->second.get())) {
-        hits_++;
-        try {
-            return std::get<int>(it->second->value);
-        }
-        catch (const std::bad_variant_access&) {
-            // Type mismatch, return default
-            return defaultValue;
-        }
+template<typename T>
+T CacheManager::getValue(std::string_view key, const T& defaultValue) {
+    Shard& shard = shardFor(key);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+
+    auto it = shard.cache.find(key);
+    if (it != shard.cache.end() && !isExpired(it->second.get())) {
+        shard.hits.fetch_add(1, std::memory_order_relaxed);
+        touch(it->second.get());
+
+        // Type mismatch, return default
+        const T* value = std::get_if<T>(&it->second->value);
+        return value ? *value : defaultValue;
     }
-    misses_++;
+    shard.misses.fetch_add(1, std::memory_order_relaxed);
     return defaultValue;
 }
 
-long long CacheManager::getLongLong(const std::string& key, long long defaultValue) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = cache_.find(key);
-    if (it != cache_.end() && !isExpired(it->second.get())) {
-        hits_++;
-        try {
-            return std::get<long long>(it->second->value);
-        }
-        catch (const std::bad_variant_access&) {
-            return defaultValue;
-        }
-    }
-    misses_++;
-    return defaultValue;
+int CacheManager::getInt(std::string_view key, int defaultValue) {
+    return getValue<int>(key, defaultValue);
 }
 
-float CacheManager::getFloat(const std::string& key, float defaultValue) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = cache_.find(key);
-    if (it != cache_.end() && !isExpired(it->second.get())) {
-        hits_++;
-        try {
-            return std::get<float>(it->second->value);
-        }
-        catch (const std::bad_variant_access&) {
-            return defaultValue;
-        }
-    }
-    misses_++;
-    return defaultValue;
+long long CacheManager::getLongLong(std::string_view key, long long defaultValue) {
+    return getValue<long long>(key, defaultValue);
 }
 
-double CacheManager::getDouble(const std::string& key, double defaultValue) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = cache_.find(key);
-    if (it != cache_.end() && !isExpired(it->second.get())) {
-        hits_++;
-        try {
-            return std::get<double>(it->second->value);
-        }
-        catch (const std::bad_variant_access&) {
-            return defaultValue;
-        }
-    }
-    misses_++;
-    return defaultValue;
+float CacheManager::getFloat(std::string_view key, float defaultValue) {
+    return getValue<float>(key, defaultValue);
 }
 
-bool CacheManager::getBool(const std::string& key, bool defaultValue) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = cache_.find(key);
-    if (it != cache_.end() && !isExpired(it->second.get())) {
-        hits_++;
-        try {
-            return std::get<bool>(it->second->value);
-        }
-        catch (const std::bad_variant_access&) {
-            return defaultValue;
-        }
-    }
-    misses_++;
-    return defaultValue;
+double CacheManager::getDouble(std::string_view key, double defaultValue) {
+    return getValue<double>(key, defaultValue);
 }
 
-std::string CacheManager::getString(const std::string& key, const std::string& defaultValue) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = cache_.find(key);
-    if (it != cache_.end() && !isExpired(it->second.get())) {
-        hits_++;
-        try {
-            return std::get<std::string>(it->second->value);
-        }
-        catch (const std::bad_variant_access&) {
-            return defaultValue;
-        }
-    }
-    misses_++;
-    return defaultValue;
+bool CacheManager::getBool(std::string_view key, bool defaultValue) {
+    return getValue<bool>(key, defaultValue);
 }
 
-std::vector<uint8_t> CacheManager::getBytes(const std::string& key) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = cache_.find(key);
-    if (it != cache_.end() && !isExpired(it->second.get())) {
-        hits_++;
-        try {
-            return std::get<std::vector<uint8_t>>(it->second->value);
-        }
-        catch (const std::bad_variant_access&) {
-            return std::vector<uint8_t>();
-        }
-    }
-    misses_++;
-    return std::vector<uint8_t>();
+std::string CacheManager::getString(std::string_view key, const std::string& defaultValue) {
+    return getValue<std::string>(key, defaultValue);
 }
 
-std::bitset<64> CacheManager::getBits(const std::string& key) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = cache_.find(key);
-    if (it != cache_.end() && !isExpired(it->second.get())) {
-        hits_++;
-        try {
-            return std::get<std::bitset<64>>(it->second->value);
-        }
-        catch (const std::bad_variant_access&) {
-            return std::bitset<64>();
-        }
-    }
-    misses_++;
-    return std::bitset<64>();
+std::vector<uint8_t> CacheManager::getBytes(std::string_view key) {
+    return getValue<std::vector<uint8_t>>(key, std::vector<uint8_t>());
+}
+
+std::bitset<64> CacheManager::getBits(std::string_view key) {
+    return getValue<std::bitset<64>>(key, std::bitset<64>());
 }
 
 // Utility operations
-bool CacheManager::exists(const std::string& key) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = cache_.find(key);
-    return it != cache_.end() && !isExpired(it->second.get());
+bool CacheManager::exists(std::string_view key) {
+    Shard& shard = shardFor(key);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.cache.find(key);
+    if (it == shard.cache.end() || isExpired(it->second.get())) {
+        return false;
+    }
+    touch(it->second.get());
+    return true;
 }
 
-bool CacheManager::isValid(const std::string& key) {
+bool CacheManager::isValid(std::string_view key) {
     return exists(key); // Same implementation for now
 }
 
 // DELETE operations
-bool CacheManager::remove(const std::string& key) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = cache_.find(key);
-    if (it != cache_.end()) {
-        cache_.erase(it);
+bool CacheManager::remove(std::string_view key) {
+    Shard& shard = shardFor(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.cache.find(key);
+    if (it != shard.cache.end()) {
+        erase(shard, it);
         return true;
     }
     return false;
 }
 
 void CacheManager::clear() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    cache_.clear();
-    hits_ = 0;
-    misses_ = 0;
+    for (Shard& shard : shards_) {
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.cache.clear();
+        shard.expiry = {};
+        shard.namespaces.clear();
+        shard.memoryUsage = 0;
+        shard.hits.store(0, std::memory_order_relaxed);
+        shard.misses.store(0, std::memory_order_relaxed);
+    }
 }
 
 // Utility methods
 std::vector<std::string> CacheManager::getKeys() {
-    std::lock_guard<std::mutex> lock(mutex_);
     std::vector<std::string> keys;
-    keys.reserve(cache_.size());
 
-    for (const auto& pair : cache_) {
-        if (!isExpired(pair.second.get())) {
-            keys.push_back(pair.first);
+    for (Shard& shard : shards_) {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        keys.reserve(keys.size() + shard.cache.size());
+
+        for (const auto& pair : shard.cache) {
+            if (!isExpired(pair.second.get())) {
+                keys.push_back(pair.first);
+            }
         }
     }
     return keys;
 }
 
 CacheManager::CacheStats CacheManager::getStats() {
-    std::lock_guard<std::mutex> lock(mutex_);
+    CacheStats stats{ 0, 0, 0, 0, 0.0, 0, {} };
+    auto now = std::chrono::steady_clock::now();
+
+    std::shared_lock<std::shared_mutex> nsLock(namespacesMutex_);
+    for (const Namespace& ns : namespaces_) {
+        stats.namespaces.push_back(NamespaceStats{ ns.prefix, 0, 0, ns.maxBytes, 0 });
+    }
 
-    size_t validEntries = 0;
-    size_t memoryUsage = 0;
+    for (Shard& shard : shards_) {
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
 
-    for (const auto& pair : cache_) {
-        if (!isExpired(pair.second.get())) {
-            validEntries++;
-            memoryUsage += estimateEntrySize(pair.first, pair.second.get());
+        // Counters are kept up to date on every write, only drop what already expired
+        purgeExpired(shard, now);
+
+        stats.size += shard.cache.size();
+        stats.memoryUsage += shard.memoryUsage;
+        stats.hits += shard.hits.load(std::memory_order_relaxed);
+        stats.misses += shard.misses.load(std::memory_order_relaxed);
+
+        for (size_t i = 0; i < shard.namespaces.size(); i++) {
+            const NamespaceState& state = shard.namespaces[i];
+            stats.namespaces[i].size += state.order.size();
+            stats.namespaces[i].memoryUsage += state.memoryUsage;
+            stats.namespaces[i].evictions += state.evictions;
+            stats.evictions += state.evictions;
         }
     }
 
-    size_t totalAccess = hits_ + misses_;
-    double hitRate = totalAccess > 0 ? static_cast<double>(hits_) / totalAccess : 0.0;
-
-    return CacheStats{
-        validEntries,
-        memoryUsage,
-        hits_,
-        misses_,
-        hitRate
-    };
+    size_t totalAccess = stats.hits + stats.misses;
+    stats.hitRate = totalAccess > 0 ? static_cast<double>(stats.hits) / totalAccess : 0.0;
+    return stats;
 }
 
 size_t CacheManager::cleanupExpired() {
-    std::lock_guard<std::mutex> lock(mutex_);
     size_t removedCount = 0;
+    auto now = std::chrono::steady_clock::now();
 
-    auto it = cache_.begin();
-    while (it != cache_.end()) {
-        if (isExpired(it->second.get())) {
-            it = cache_.erase(it);
-            removedCount++;
+    for (Shard& shard : shards_) {
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        removedCount += purgeExpired(shard, now);
+    }
+    return removedCount;
+}
+
+size_t CacheManager::getMemoryUsage() {
+    return getStats().memoryUsage;
+}
+
+bool CacheManager::saveSnapshot(const std::string& path) {
+    SnapshotWriter writer(SNAPSHOT_MAGIC, SNAPSHOT_VERSION);
+    auto steadyNow = std::chrono::steady_clock::now();
+    auto systemNow = std::chrono::system_clock::now();
+
+    size_t countOffset = writer.offset();
+    uint64_t count = 0;
+    writer.write(count);
+
+    // Record: type, deadline, key length, key, value
+    for (Shard& shard : shards_) {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+
+        for (const auto& pair : shard.cache) {
+            const CacheEntry* entry = pair.second.get();
+            if (isExpired(entry)) {
+                continue;
+            }
+
+            writer.write(static_cast<uint8_t>(entry->value.index()));
+            writer.write(SnapshotWriter::deadline(entry->expiresAt, steadyNow, systemNow));
+            writer.write(static_cast<uint32_t>(pair.first.size()));
+            writer.writeBytes(pair.first.data(), pair.first.size());
+
+            std::visit([&writer](const auto& value) {
+                using T = std::decay_t<decltype(value)>;
+                if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::vector<uint8_t>>) {
+                    writer.write(static_cast<uint32_t>(value.size()));
+                    writer.writeBytes(value.data(), value.size());
+                }
+                else if constexpr (std::is_same_v<T, std::bitset<64>>) {
+                    writer.write(static_cast<uint64_t>(value.to_ullong()));
+                }
+                else {
+                    writer.write(value);
+                }
+                }, entry->value);
+            count++;
+        }
+    }
+
+    writer.patch(countOffset, count);
+    return writer.commit(path);
+}
+
+size_t CacheManager::loadSnapshot(const std::string& path) {
+    MappedFile file;
+    if (!file.open(path)) {
+        return 0;
+    }
+
+    SnapshotReader reader(file.data(), file.size());
+    uint64_t count = 0;
+    if (!reader.header(SNAPSHOT_MAGIC, SNAPSHOT_VERSION) || !reader.read(count)) {
+        return 0;
+    }
+
+    auto steadyNow = std::chrono::steady_clock::now();
+    auto systemNow = std::chrono::system_clock::now();
+    size_t loaded = 0;
+
+    for (uint64_t i = 0; i < count; i++) {
+        uint8_t type = 0;
+        int64_t deadline = 0;
+        uint32_t keySize = 0;
+        std::string_view key;
+        if (!reader.read(type) || !reader.read(deadline) || !reader.read(keySize) || !reader.readBytes(key, keySize)) {
+            break; // Truncated snapshot, keep what was restored so far
+        }
+
+        CacheValue value;
+        bool valid = true;
+        switch (type) {
+        case 0: { int v; valid = reader.read(v); value = v; break; }
+        case 1: { long long v; valid = reader.read(v); value = v; break; }
+        case 2: { float v; valid = reader.read(v); value = v; break; }
+        case 3: { double v; valid = reader.read(v); value = v; break; }
+        case 4: { bool v; valid = reader.read(v); value = v; break; }
+        case 5:
+        case 6: {
+            uint32_t size = 0;
+            std::string_view bytes;
+            valid = reader.read(size) && reader.readBytes(bytes, size);
+            if (type == 5) {
+                value = std::string(bytes);
+            }
+            else {
+                value = std::vector<uint8_t>(bytes.begin(), bytes.end());
+            }
+            break;
+        }
+        case 7: { uint64_t v = 0; valid = reader.read(v); value = std::bitset<64>(v); break; }
+        default: valid = false; break;
+        }
+        if (!valid) {
+            break;
+        }
+
+        std::chrono::steady_clock::time_point expiresAt;
+        std::chrono::milliseconds remaining;
+        if (!SnapshotReader::deadline(deadline, expiresAt, remaining, steadyNow, systemNow)) {
+            continue; // Expired while the server was down
+        }
+
+        std::unique_ptr<CacheEntry> entry;
+        if (deadline == 0) {
+            entry = std::make_unique<CacheEntry>(value);
         }
         else {
-            ++it;
+            entry = std::make_unique<CacheEntry>(value, std::chrono::ceil<std::chrono::seconds>(remaining));
+            entry->expiresAt = expiresAt;
         }
+        store(key, std::move(entry));
+        loaded++;
     }
 
-    return removedCount;
+    return loaded;
 }
 
-size_t CacheManager::getMemoryUsage() {
-    return getStats().memoryUsage;
+void CacheManager::setMemoryBudget(size_t maxBytes) {
+    memoryBudget_.store(maxBytes, std::memory_order_relaxed);
+}
+
+void CacheManager::configureNamespace(std::string_view prefix, size_t maxBytes, EvictionPolicy policy) {
+    std::unique_lock<std::shared_mutex> lock(namespacesMutex_);
+
+    for (Namespace& ns : namespaces_) {
+        if (ns.prefix == prefix) {
+            ns.maxBytes = maxBytes;
+            ns.policy = policy;
+            return;
+        }
+    }
+    namespaces_.push_back(Namespace{ std::string(prefix), maxBytes, policy });
 }
 
 // Private helper methods
+CacheManager::Shard& CacheManager::shardFor(std::string_view key) {
+    // Fibonacci hashing, the top bits pick the shard so they stay independent of the map buckets
+    uint64_t hash = static_cast<uint64_t>(KeyHash{}(key)) * 0x9E3779B97F4A7C15ull;
+    return shards_[hash >> (64 - SHARD_BITS)];
+}
+
+size_t CacheManager::namespaceFor(std::string_view key) {
+    // Longest registered prefix wins, falls back to the default namespace
+    size_t best = 0;
+    for (size_t i = 1; i < namespaces_.size(); i++) {
+        const std::string& prefix = namespaces_[i].prefix;
+        if (key.substr(0, prefix.size()) == prefix && prefix.size() > namespaces_[best].prefix.size()) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+void CacheManager::touch(const CacheEntry* entry) {
+    // Skip the store when already set, keeps hot entries from bouncing their cache line
+    if (!entry->referenced.load(std::memory_order_relaxed)) {
+        entry->referenced.store(true, std::memory_order_relaxed);
+    }
+}
+
 bool CacheManager::isExpired(const CacheEntry* entry) {
     if (!entry->hasTTL) {
         return false; // No TTL set, never expires
     }
 
-    auto now = std::chrono::steady_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - entry->createdAt);
-    return elapsed >= entry->ttl;
+    return std::chrono::steady_clock::now() >= entry->expiresAt;
+}
+
+void CacheManager::store(std::string_view key, std::unique_ptr<CacheEntry> entry) {
+    entry->size = estimateEntrySize(key, entry.get());
+
+    std::shared_lock<std::shared_mutex> nsLock(namespacesMutex_);
+    size_t ns = namespaceFor(key);
+
+    Shard& shard = shardFor(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+
+    if (shard.namespaces.size() < namespaces_.size()) {
+        shard.namespaces.resize(namespaces_.size());
+    }
+
+    entry->version = ++shard.nextVersion;
+    if (entry->hasTTL) {
+        shard.expiry.push(ExpiryNode{ entry->expiresAt, entry->version, std::string(key) });
+    }
+
+    auto it = shard.cache.find(key);
+    if (it != shard.cache.end()) {
+        unlink(shard, it->second.get());
+        it->second = std::move(entry);
+    }
+    else {
+        it = shard.cache.emplace(std::string(key), std::move(entry)).first;
+    }
+    link(shard, it, ns);
+    enforceBudget(shard, ns);
+
+    // Overwritten keys leave stale nodes behind, rebuild before the index outgrows the shard
+    if (shard.expiry.size() > 1024 && shard.expiry.size() > shard.cache.size() * 2) {
+        std::vector<ExpiryNode> live;
+        live.reserve(shard.cache.size());
+        for (const auto& pair : shard.cache) {
+            if (pair.second->hasTTL) {
+                live.push_back(ExpiryNode{ pair.second->expiresAt, pair.second->version, pair.first });
+            }
+        }
+        shard.expiry = ExpiryQueue(std::greater<ExpiryNode>(), std::move(live));
+    }
+}
+
+void CacheManager::erase(Shard& shard, EntryMap::iterator it) {
+    unlink(shard, it->second.get());
+    shard.cache.erase(it);
+}
+
+void CacheManager::link(Shard& shard, EntryMap::iterator it, size_t ns) {
+    CacheEntry* entry = it->second.get();
+    NamespaceState& state = shard.namespaces[ns];
+
+    // Map nodes never move, the key address stays valid until the entry is erased
+    entry->ns = ns;
+    entry->order = state.order.insert(state.order.end(), &it->first);
+    state.memoryUsage += entry->size;
+    shard.memoryUsage += entry->size;
+}
+
+void CacheManager::unlink(Shard& shard, CacheEntry* entry) {
+    NamespaceState& state = shard.namespaces[entry->ns];
+
+    state.order.erase(entry->order);
+    state.memoryUsage -= entry->size;
+    shard.memoryUsage -= entry->size;
+}
+
+bool CacheManager::evictOne(Shard& shard, size_t ns) {
+    NamespaceState& state = shard.namespaces[ns];
+    bool secondChance = namespaces_[ns].policy == EvictionPolicy::LRU;
+
+    // Every referenced entry is moved back once with its bit cleared, so this ends within two passes
+    while (!state.order.empty()) {
+        auto it = shard.cache.find(*state.order.front());
+        CacheEntry* entry = it->second.get();
+
+        if (secondChance && entry->referenced.exchange(false, std::memory_order_relaxed)) {
+            state.order.splice(state.order.end(), state.order, entry->order);
+            continue;
+        }
+
+        erase(shard, it);
+        state.evictions++;
+        return true;
+    }
+    return false;
+}
+
+void CacheManager::enforceBudget(Shard& shard, size_t ns) {
+    size_t quota = namespaces_[ns].maxBytes;
+    size_t budget = memoryBudget_.load(std::memory_order_relaxed);
+
+    // Each shard holds roughly 1/SHARD_COUNT of the keys, give it the same share of the limits
+    quota = quota ? std::max<size_t>(quota / SHARD_COUNT, 1) : 0;
+    budget = budget ? std::max<size_t>(budget / SHARD_COUNT, 1) : 0;
+
+    bool overQuota = quota && shard.namespaces[ns].memoryUsage > quota;
+    bool overBudget = budget && shard.memoryUsage > budget;
+    if (!overQuota && !overBudget) {
+        return;
+    }
+
+    // Whatever already expired goes first, it costs nothing to drop
+    purgeExpired(shard, std::chrono::steady_clock::now());
+
+    while (quota && shard.namespaces[ns].memoryUsage > quota && evictOne(shard, ns)) {
+    }
+
+    // Over the global budget, take from the namespace holding the most memory in this shard
+    while (budget && shard.memoryUsage > budget) {
+        size_t victim = 0;
+        for (size_t i = 1; i < shard.namespaces.size(); i++) {
+            if (shard.namespaces[i].memoryUsage > shard.namespaces[victim].memoryUsage) {
+                victim = i;
+            }
+        }
+        if (!evictOne(shard, victim)) {
+            break;
+        }
+    }
+}
+
+size_t CacheManager::purgeExpired(Shard& shard, std::chrono::steady_clock::time_point now) {
+    size_t removedCount = 0;
+
+    while (!shard.expiry.empty() && shard.expiry.top().deadline <= now) {
+        const ExpiryNode& node = shard.expiry.top();
+
+        auto it = shard.cache.find(node.key);
+        if (it != shard.cache.end() && it->second->version == node.version) {
+            erase(shard, it);
+            removedCount++;
+        }
+        shard.expiry.pop();
+    }
+
+    return removedCount;
 }
 
-size_t CacheManager::estimateEntrySize(const std::string& key, const CacheEntry* entry) {
+size_t CacheManager::estimateEntrySize(std::string_view key, const CacheEntry* entry) {
     size_t size = key.size() + sizeof(CacheEntry);
 
     std::visit([&size](const auto& value) {
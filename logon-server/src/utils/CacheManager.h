@@ -6,13 +6,30 @@
 #include <variant>
 #include <chrono>
 #include <unordered_map>
+#include <queue>
+#include <list>
+#include <memory>
 #include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <array>
+#include <string_view>
 #include <fmt/format.h>
 #include <fmt/color.h>
 
 /**
  * @fileoverview CacheManager - Lightweight memory cache system with bit-efficient storage
  *
+ * Keys are spread over SHARD_COUNT independently locked shards, readers of
+ * different keys (and concurrent readers of the same shard) never wait on
+ * each other. Keys are accepted as std::string_view, lookups do not allocate.
+ *
+ * Memory is bounded by an optional global budget and per-namespace quotas. A
+ * namespace is a key prefix such as "ip:" or "session:", keys matching no
+ * configured prefix belong to the default namespace. Budgets are split evenly
+ * over the shards; when a write pushes a shard over its share, entries of the
+ * namespace are evicted following its EvictionPolicy.
+ *
  * @example Basic Usage:
  * ```cpp
  * // Store different types of data
@@ -58,6 +75,23 @@
  * std::cout << "Memory usage: " << stats.memoryUsage << " bytes" << std::endl;
  * ```
  *
+ * @example Memory Budget:
+ * ```cpp
+ * // Whole cache limited to 64 MiB, IP reputation results to 16 MiB
+ * CacheManager::setMemoryBudget(64 * 1024 * 1024);
+ * CacheManager::configureNamespace("ip:", 16 * 1024 * 1024, CacheManager::EvictionPolicy::LRU);
+ *
+ * CacheManager::setWithTTL("ip:127.0.0.1", 1, 300);
+ * auto stats = CacheManager::getStats();
+ * std::cout << "Evicted: " << stats.evictions << std::endl;
+ * ```
+ *
+ * @example Warm Restart:
+ * ```cpp
+ * CacheManager::loadSnapshot("../snapshot/cache.bin");   // At startup, expired entries are skipped
+ * CacheManager::saveSnapshot("../snapshot/cache.bin");   // On shutdown and periodically
+ * ```
+ *
  * @example Bit Operations:
  * ```cpp
  * // Store flags as bits (memory efficient)
@@ -88,24 +122,45 @@ public:
         std::bitset<64>
     >;
 
+    // How a namespace picks its victim once it is over budget
+    enum class EvictionPolicy {
+        LRU,    // Least recently used, approximated with a second chance (CLOCK) bit so reads stay shared
+        FIFO    // Oldest write first, reads never affect the order
+    };
+
     // Cache entry with optional TTL
     struct CacheEntry {
         CacheValue value;
         std::chrono::steady_clock::time_point createdAt;
         std::chrono::seconds ttl;
         bool hasTTL;
+        std::chrono::steady_clock::time_point expiresAt;
+        uint64_t version = 0;   // Matches the expiry index entry of this value
+        size_t size = 0;        // estimateEntrySize, cached for incremental stats
+        size_t ns = 0;          // Namespace index, see configureNamespace
+        std::list<const std::string*>::iterator order;  // Position in the namespace eviction list
+        mutable std::atomic<bool> referenced{ false };  // Set on read, gives the entry a second chance
 
         CacheEntry(const CacheValue& val)
             : value(val), createdAt(std::chrono::steady_clock::now()),
-            ttl(0), hasTTL(false) {
+            ttl(0), hasTTL(false), expiresAt(std::chrono::steady_clock::time_point::max()) {
         }
 
         CacheEntry(const CacheValue& val, std::chrono::seconds ttlSeconds)
             : value(val), createdAt(std::chrono::steady_clock::now()),
-            ttl(ttlSeconds), hasTTL(true) {
+            ttl(ttlSeconds), hasTTL(true), expiresAt(createdAt + ttlSeconds) {
         }
     };
 
+    // Per-namespace statistics
+    struct NamespaceStats {
+        std::string prefix;     // Empty for the default namespace
+        size_t size;
+        size_t memoryUsage;
+        size_t maxBytes;        // 0 when unlimited
+        size_t evictions;
+    };
+
     // Cache statistics
     struct CacheStats {
         size_t size;
@@ -113,6 +168,8 @@ public:
         size_t hits;
         size_t misses;
         double hitRate;
+        size_t evictions;
+        std::vector<NamespaceStats> namespaces;
     };
 
     // CRUD Operations
@@ -122,56 +179,56 @@ public:
      * @param key The cache key
      * @param value Integer value to store
      */
-    static void set(const std::string& key, int value);
+    static void set(std::string_view key, int value);
 
     /**
      * @brief Store long long value in cache
      * @param key The cache key
      * @param value Long long value to store
      */
-    static void set(const std::string& key, long long value);
+    static void set(std::string_view key, long long value);
 
     /**
      * @brief Store float value in cache
      * @param key The cache key
      * @param value Float value to store
      */
-    static void set(const std::string& key, float value);
+    static void set(std::string_view key, float value);
 
     /**
      * @brief Store double value in cache
      * @param key The cache key
      * @param value Double value to store
      */
-    static void set(const std::string& key, double value);
+    static void set(std::string_view key, double value);
 
     /**
      * @brief Store boolean value in cache
      * @param key The cache key
      * @param value Boolean value to store
      */
-    static void set(const std::string& key, bool value);
+    static void set(std::string_view key, bool value);
 
     /**
      * @brief Store string value in cache
      * @param key The cache key
      * @param value String value to store
      */
-    static void set(const std::string& key, const std::string& value);
+    static void set(std::string_view key, const std::string& value);
 
     /**
      * @brief Store binary data in cache
      * @param key The cache key
      * @param value Vector of bytes to store
      */
-    static void set(const std::string& key, const std::vector<uint8_t>& value);
+    static void set(std::string_view key, const std::vector<uint8_t>& value);
 
     /**
      * @brief Store bitset in cache (memory efficient for flags)
      * @param key The cache key
      * @param value Bitset to store
      */
-    static void setBits(const std::string& key, const std::bitset<64>& value);
+    static void setBits(std::string_view key, const std::bitset<64>& value);
 
     /**
      * @brief Store value with TTL (Time To Live)
@@ -180,7 +237,7 @@ public:
      * @param ttlSeconds TTL in seconds
      */
     template<typename T>
-    static void setWithTTL(const std::string& key, const T& value, int ttlSeconds);
+    static void setWithTTL(std::string_view key, const T& value, int ttlSeconds);
 
     /**
      * @brief Get integer value from cache
@@ -188,7 +245,7 @@ public:
      * @param defaultValue Default value if key not found
      * @return Integer value or default
      */
-    static int getInt(const std::string& key, int defaultValue = 0);
+    static int getInt(std::string_view key, int defaultValue = 0);
 
     /**
      * @brief Get long long value from cache
@@ -196,7 +253,7 @@ public:
      * @param defaultValue Default value if key not found
      * @return Long long value or default
      */
-    static long long getLongLong(const std::string& key, long long defaultValue = 0);
+    static long long getLongLong(std::string_view key, long long defaultValue = 0);
 
     /**
      * @brief Get float value from cache
@@ -204,7 +261,7 @@ public:
      * @param defaultValue Default value if key not found
      * @return Float value or default
      */
-    static float getFloat(const std::string& key, float defaultValue = 0.0f);
+    static float getFloat(std::string_view key, float defaultValue = 0.0f);
 
     /**
      * @brief Get double value from cache
@@ -212,7 +269,7 @@ public:
      * @param defaultValue Default value if key not found
      * @return Double value or default
      */
-    static double getDouble(const std::string& key, double defaultValue = 0.0);
+    static double getDouble(std::string_view key, double defaultValue = 0.0);
 
     /**
      * @brief Get boolean value from cache
@@ -220,7 +277,7 @@ public:
      * @param defaultValue Default value if key not found
      * @return Boolean value or default
      */
-    static bool getBool(const std::string& key, bool defaultValue = false);
+    static bool getBool(std::string_view key, bool defaultValue = false);
 
     /**
      * @brief Get string value from cache
@@ -228,42 +285,42 @@ public:
      * @param defaultValue Default value if key not found
      * @return String value or default
      */
-    static std::string getString(const std::string& key, const std::string& defaultValue = "");
+    static std::string getString(std::string_view key, const std::string& defaultValue = "");
 
     /**
      * @brief Get binary data from cache
      * @param key The cache key
      * @return Vector of bytes or empty vector if not found
      */
-    static std::vector<uint8_t> getBytes(const std::string& key);
+    static std::vector<uint8_t> getBytes(std::string_view key);
 
     /**
      * @brief Get bitset from cache
      * @param key The cache key
      * @return Bitset or empty bitset if not found
      */
-    static std::bitset<64> getBits(const std::string& key);
+    static std::bitset<64> getBits(std::string_view key);
 
     /**
      * @brief Check if key exists and is valid (not expired)
      * @param key The cache key
      * @return True if exists and valid
      */
-    static bool exists(const std::string& key);
+    static bool exists(std::string_view key);
 
     /**
      * @brief Check if key exists and is still valid (TTL check)
      * @param key The cache key
      * @return True if exists and not expired
      */
-    static bool isValid(const std::string& key);
+    static bool isValid(std::string_view key);
 
     /**
      * @brief Remove specific key from cache
      * @param key The cache key to remove
      * @return True if key was removed
      */
-    static bool remove(const std::string& key);
+    static bool remove(std::string_view key);
 
     /**
      * @brief Clear all cache entries
@@ -285,9 +342,40 @@ public:
     /**
      * @brief Clean up expired entries
      * @return Number of entries removed
+     * @note Only visits entries whose deadline passed, cost is O(expired log n)
      */
     static size_t cleanupExpired();
 
+    /**
+     * @brief Limit the estimated memory of the whole cache
+     * @param maxBytes Budget in bytes, 0 disables the limit
+     */
+    static void setMemoryBudget(size_t maxBytes);
+
+    /**
+     * @brief Register or update a key namespace with its own quota
+     * @param prefix Key prefix, e.g. "ip:"
+     * @param maxBytes Quota in bytes, 0 disables the limit
+     * @param policy Eviction policy applied when the quota is exceeded
+     * @note Entries stored before the prefix was registered stay in the default namespace
+     */
+    static void configureNamespace(std::string_view prefix, size_t maxBytes, EvictionPolicy policy = EvictionPolicy::LRU);
+
+    /**
+     * @brief Write every live entry with its remaining TTL to a binary snapshot
+     * @param path Snapshot file, replaced atomically
+     * @return False if the file could not be written
+     */
+    static bool saveSnapshot(const std::string& path);
+
+    /**
+     * @brief Load a snapshot written by saveSnapshot, the file is memory-mapped
+     * @param path Snapshot file
+     * @return Number of entries restored, expired ones are skipped
+     * @note Call after the namespaces are configured so restored keys land in them
+     */
+    static size_t loadSnapshot(const std::string& path);
+
     /**
      * @brief Get memory usage estimation in bytes
      * @return Estimated memory usage
@@ -295,22 +383,83 @@ public:
     static size_t getMemoryUsage();
 
 private:
-    static std::unordered_map<std::string, std::unique_ptr<CacheEntry>> cache_;
-    static std::mutex mutex_;
-    static size_t hits_;
-    static size_t misses_;
+    // Expiry index node, stale once the key is overwritten or removed (version mismatch)
+    struct ExpiryNode {
+        std::chrono::steady_clock::time_point deadline;
+        uint64_t version;
+        std::string key;
+
+        bool operator>(const ExpiryNode& other) const { return deadline > other.deadline; }
+    };
+
+    // Transparent hash so lookups by std::string_view never build a temporary std::string
+    struct KeyHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view key) const noexcept { return std::hash<std::string_view>{}(key); }
+    };
+
+    using EntryMap = std::unordered_map<std::string, std::unique_ptr<CacheEntry>, KeyHash, std::equal_to<>>;
+    using ExpiryQueue = std::priority_queue<ExpiryNode, std::vector<ExpiryNode>, std::greater<ExpiryNode>>;
 
-    // Internal helper methods
+    struct Namespace {
+        std::string prefix;
+        size_t maxBytes;
+        EvictionPolicy policy;
+    };
+
+    // Share of one namespace inside a shard, order holds pointers to the map keys
+    struct NamespaceState {
+        std::list<const std::string*> order;
+        size_t memoryUsage = 0;
+        size_t evictions = 0;
+    };
+
+    // One lock stripe, readers share the lock and only bump the atomic counters
+    struct alignas(64) Shard {
+        std::shared_mutex mutex;
+        EntryMap cache;
+        ExpiryQueue expiry;
+        std::vector<NamespaceState> namespaces;     // Indexed like namespaces_, grown lazily
+        size_t memoryUsage = 0;
+        uint64_t nextVersion = 0;
+        std::atomic<size_t> hits{ 0 };
+        std::atomic<size_t> misses{ 0 };
+    };
+
+    static constexpr size_t SHARD_BITS = 4;
+    static constexpr size_t SHARD_COUNT = size_t(1) << SHARD_BITS;
+
+    static std::array<Shard, SHARD_COUNT> shards_;
+
+    // Registered namespaces, [0] is the default one. Lock order: namespacesMutex_ before any shard
+    static std::vector<Namespace> namespaces_;
+    static std::shared_mutex namespacesMutex_;
+    static std::atomic<size_t> memoryBudget_;
+
+    // Internal helper methods, the shard lock must be held by the caller
+    static Shard& shardFor(std::string_view key);
+    static size_t namespaceFor(std::string_view key);
+    static void touch(const CacheEntry* entry);
     static bool isExpired(const CacheEntry* entry);
-    static size_t estimateEntrySize(const std::string& key, const CacheEntry* entry);
+    static size_t estimateEntrySize(std::string_view key, const CacheEntry* entry);
+    static void store(std::string_view key, std::unique_ptr<CacheEntry> entry);
+    static void erase(Shard& shard, EntryMap::iterator it);
+    static void link(Shard& shard, EntryMap::iterator it, size_t ns);
+    static void unlink(Shard& shard, CacheEntry* entry);
+    static bool evictOne(Shard& shard, size_t ns);
+    static void enforceBudget(Shard& shard, size_t ns);
+    static size_t purgeExpired(Shard& shard, std::chrono::steady_clock::time_point now);
+
+    template<typename T>
+    static T getValue(std::string_view key, const T& defaultValue);
 
     // Template implementation for setWithTTL
     template<typename T>
-    static void setWithTTLImpl(const std::string& key, const T& value, int ttlSeconds);
+    static void setWithTTLImpl(std::string_view key, const T& value, int ttlSeconds);
 };
 
 // Template method implementation
 template<typename T>
-void CacheManager::setWithTTL(const std::string& key, const T& value, int ttlSeconds) {
+void CacheManager::setWithTTL(std::string_view key, const T& value, int ttlSeconds) {
     setWithTTLImpl(key, value, ttlSeconds);
 }
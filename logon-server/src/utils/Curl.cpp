@@ -56,6 +56,9 @@ Curl::Curl() : curl_(nullptr), res_(CURLE_OK), headersList_(nullptr) {
         // Set default verbose to off
         curl_easy_setopt(curl_, CURLOPT_VERBOSE, 0L);
 
+        // Timeouts must not rely on signals, requests can run outside the main thread
+        curl_easy_setopt(curl_, CURLOPT_NOSIGNAL, 1L);
+
         // Enable following redirects by default
         setFollowRedirects(true);
     } else {
@@ -0,0 +1,270 @@
+#include "DelimiterScanner.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define DELIMITER_SCANNER_X86 1
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #endif
+#else
+    #define DELIMITER_SCANNER_X86 0
+#endif
+
+// GCC and Clang only emit AVX2/SSE2 code inside functions explicitly targeting it, MSVC always does
+#if DELIMITER_SCANNER_X86 && (defined(__GNUC__) || defined(__clang__))
+    #define TARGET_SSE2 __attribute__((target("sse2")))
+    #define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+    #define TARGET_SSE2
+    #define TARGET_AVX2
+#endif
+
+namespace {
+    using KernelFn = const char* (*)(const char* begin, const char* end, const char delims[4]);
+    using HitFn = bool (*)(void* ctx, size_t pos);
+    using ScanFn = bool (*)(const char* base, const char* begin, const char* end, const char delims[4], HitFn hit, void* ctx);
+
+    // Index of the lowest set bit, mask is never zero
+    inline unsigned lowestBit(unsigned mask) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return static_cast<unsigned>(index);
+#else
+        return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+    }
+
+    const char* findAnyScalar(const char* begin, const char* end, const char delims[4]) {
+        for (const char* p = begin; p < end; p++) {
+            if (*p == delims[0] || *p == delims[1] || *p == delims[2] || *p == delims[3]) {
+                return p;
+            }
+        }
+        return end;
+    }
+
+    bool scanAnyScalar(const char* base, const char* begin, const char* end, const char delims[4], HitFn hit, void* ctx) {
+        for (const char* p = begin; p < end; p++) {
+            if ((*p == delims[0] || *p == delims[1] || *p == delims[2] || *p == delims[3]) && !hit(ctx, static_cast<size_t>(p - base))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+#if DELIMITER_SCANNER_X86
+    TARGET_SSE2 const char* findAnySSE2(const char* begin, const char* end, const char delims[4]) {
+        const __m128i d0 = _mm_set1_epi8(delims[0]);
+        const __m128i d1 = _mm_set1_epi8(delims[1]);
+        const __m128i d2 = _mm_set1_epi8(delims[2]);
+        const __m128i d3 = _mm_set1_epi8(delims[3]);
+
+        const char* p = begin;
+        for (; end - p >= 16; p += 16) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            __m128i hits = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(block, d0), _mm_cmpeq_epi8(block, d1)),
+                _mm_or_si128(_mm_cmpeq_epi8(block, d2), _mm_cmpeq_epi8(block, d3)));
+
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hits));
+            if (mask != 0) {
+                return p + lowestBit(mask);
+            }
+        }
+        return findAnyScalar(p, end, delims);
+    }
+
+    TARGET_AVX2 const char* findAnyAVX2(const char* begin, const char* end, const char delims[4]) {
+        const __m256i d0 = _mm256_set1_epi8(delims[0]);
+        const __m256i d1 = _mm256_set1_epi8(delims[1]);
+        const __m256i d2 = _mm256_set1_epi8(delims[2]);
+        const __m256i d3 = _mm256_set1_epi8(delims[3]);
+
+        const char* p = begin;
+        for (; end - p >= 32; p += 32) {
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            __m256i hits = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(block, d0), _mm256_cmpeq_epi8(block, d1)),
+                _mm256_or_si256(_mm256_cmpeq_epi8(block, d2), _mm256_cmpeq_epi8(block, d3)));
+
+            unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hits));
+            if (mask != 0) {
+                return p + lowestBit(mask);
+            }
+        }
+        // Tail of 0-31 bytes, one SSE2 block still beats the scalar loop
+        return findAnySSE2(p, end, delims);
+    }
+
+    // Same compares as findAny, every set bit of a block's mask is a match
+    TARGET_SSE2 bool scanAnySSE2(const char* base, const char* begin, const char* end, const char delims[4], HitFn hit, void* ctx) {
+        const __m128i d0 = _mm_set1_epi8(delims[0]);
+        const __m128i d1 = _mm_set1_epi8(delims[1]);
+        const __m128i d2 = _mm_set1_epi8(delims[2]);
+        const __m128i d3 = _mm_set1_epi8(delims[3]);
+
+        const char* p = begin;
+        for (; end - p >= 16; p += 16) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            __m128i hits = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(block, d0), _mm_cmpeq_epi8(block, d1)),
+                _mm_or_si128(_mm_cmpeq_epi8(block, d2), _mm_cmpeq_epi8(block, d3)));
+
+            for (unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hits)); mask != 0; mask &= mask - 1) {
+                if (!hit(ctx, static_cast<size_t>(p - base) + lowestBit(mask))) {
+                    return false;
+                }
+            }
+        }
+        return scanAnyScalar(base, p, end, delims, hit, ctx);
+    }
+
+    TARGET_AVX2 bool scanAnyAVX2(const char* base, const char* begin, const char* end, const char delims[4], HitFn hit, void* ctx) {
+        const __m256i d0 = _mm256_set1_epi8(delims[0]);
+        const __m256i d1 = _mm256_set1_epi8(delims[1]);
+        const __m256i d2 = _mm256_set1_epi8(delims[2]);
+        const __m256i d3 = _mm256_set1_epi8(delims[3]);
+
+        const char* p = begin;
+        for (; end - p >= 32; p += 32) {
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            __m256i hits = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(block, d0), _mm256_cmpeq_epi8(block, d1)),
+                _mm256_or_si256(_mm256_cmpeq_epi8(block, d2), _mm256_cmpeq_epi8(block, d3)));
+
+            for (unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hits)); mask != 0; mask &= mask - 1) {
+                if (!hit(ctx, static_cast<size_t>(p - base) + lowestBit(mask))) {
+                    return false;
+                }
+            }
+        }
+        return scanAnySSE2(base, p, end, delims, hit, ctx);
+    }
+
+    bool cpuHasAVX2() {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) {
+            return false;
+        }
+
+        // The OS must save the YMM registers too (OSXSAVE + XCR0 bits 1 and 2)
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) {
+            return false;
+        }
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif
+
+    DelimiterScanner::Kernel detectKernel() {
+#if DELIMITER_SCANNER_X86
+        if (cpuHasAVX2()) {
+            return DelimiterScanner::Kernel::AVX2;
+        }
+        return DelimiterScanner::Kernel::SSE2;
+#else
+        return DelimiterScanner::Kernel::Scalar;
+#endif
+    }
+
+    KernelFn selectKernel() {
+        switch (DelimiterScanner::activeKernel()) {
+#if DELIMITER_SCANNER_X86
+        case DelimiterScanner::Kernel::AVX2:
+            return findAnyAVX2;
+        case DelimiterScanner::Kernel::SSE2:
+            return findAnySSE2;
+#endif
+        default:
+            return findAnyScalar;
+        }
+    }
+
+    ScanFn selectScanKernel() {
+        switch (DelimiterScanner::activeKernel()) {
+#if DELIMITER_SCANNER_X86
+        case DelimiterScanner::Kernel::AVX2:
+            return scanAnyAVX2;
+        case DelimiterScanner::Kernel::SSE2:
+            return scanAnySSE2;
+#endif
+        default:
+            return scanAnyScalar;
+        }
+    }
+
+    // Unused lanes repeat the first delimiter, comparing against it twice is harmless
+    void fillSet(std::string_view delims, char set[4]) {
+        for (size_t i = 0; i < 4; i++) {
+            set[i] = delims[i < delims.size() ? i : 0];
+        }
+    }
+}
+
+DelimiterScanner::Kernel DelimiterScanner::activeKernel() {
+    static const Kernel kernel = detectKernel();
+    return kernel;
+}
+
+size_t DelimiterScanner::findAny(std::string_view text, std::string_view delims, size_t pos) {
+    static const KernelFn kernel = selectKernel();
+
+    if (pos >= text.size() || delims.empty()) {
+        return std::string_view::npos;
+    }
+
+    // The C runtime's memchr is already vectorized and hard to beat for a single byte
+    if (delims.size() == 1) {
+        const void* hit = std::memchr(text.data() + pos, delims[0], text.size() - pos);
+        return hit ? static_cast<size_t>(static_cast<const char*>(hit) - text.data()) : std::string_view::npos;
+    }
+
+    char set[4];
+    fillSet(delims, set);
+
+    const char* end = text.data() + text.size();
+    const char* hit = kernel(text.data() + pos, end, set);
+    return hit == end ? std::string_view::npos : static_cast<size_t>(hit - text.data());
+}
+
+void DelimiterScanner::scanAny(std::string_view text, std::string_view delims, HitFn hit, void* ctx) {
+    static const ScanFn kernel = selectScanKernel();
+
+    if (text.empty() || delims.empty()) {
+        return;
+    }
+
+    char set[4];
+    fillSet(delims, set);
+    kernel(text.data(), text.data(), text.data() + text.size(), set, hit, ctx);
+}
+
+size_t DelimiterScanner::find(std::string_view text, std::string_view delim, size_t pos) {
+    if (delim.size() <= 1) {
+        return delim.empty() ? (pos <= text.size() ? pos : std::string_view::npos) : find(text, delim[0], pos);
+    }
+
+    while (pos + delim.size() <= text.size()) {
+        pos = find(text, delim[0], pos);
+        if (pos == std::string_view::npos || pos + delim.size() > text.size()) {
+            return std::string_view::npos;
+        }
+        if (std::memcmp(text.data() + pos + 1, delim.data() + 1, delim.size() - 1) == 0) {
+            return pos;
+        }
+        pos++;
+    }
+    return std::string_view::npos;
+}
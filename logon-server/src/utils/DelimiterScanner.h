@@ -0,0 +1,122 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @fileoverview DelimiterScanner - Vectorized delimiter search for the text protocol
+ *
+ * Finds any of up to four delimiters ('\n', '|', '&', '=') 16 (SSE2) or 32 (AVX2)
+ * bytes at a time. The kernel is picked once at runtime from what the CPU
+ * supports, other architectures use a scalar loop. A single delimiter goes to
+ * memchr, which the C runtime already vectorizes. Every split helper hands out
+ * spans (std::string_view) into the source buffer, copying is left to the caller.
+ *
+ * @example
+ * ```cpp
+ * // Position of the first '|' or '\n'
+ * size_t pos = DelimiterScanner::findAny(text, "|\n");
+ *
+ * // Every '|' and '\n', one pass over the buffer
+ * DelimiterScanner::forEachAny(text, "|\n", [&](size_t pos) {
+ *     return true; // false stops the scan
+ * });
+ *
+ * // Visit every field without allocating
+ * DelimiterScanner::forEachSpan(line, "|", [](std::string_view field) {
+ *     // field points into line
+ * });
+ *
+ * std::vector<std::string_view> parts;
+ * DelimiterScanner::split("a&b=c", "&", parts); // { "a", "b=c" }
+ * ```
+ */
+
+class DelimiterScanner {
+public:
+    enum class Kernel {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    /**
+     * @brief Kernel selected for this CPU
+     */
+    static Kernel activeKernel();
+
+    /**
+     * @brief First byte of text at or after pos equal to any byte of delims
+     * @param delims One to four delimiter bytes, extra bytes are ignored
+     * @return Position of the match, std::string_view::npos if none
+     */
+    static size_t findAny(std::string_view text, std::string_view delims, size_t pos = 0);
+
+    /**
+     * @brief Call fn(pos) for every byte of text equal to any byte of delims, in order
+     * @param delims One to four delimiter bytes, extra bytes are ignored
+     * @note Each block is loaded once and all of its matches visited. fn returns false to stop
+     */
+    template<typename F>
+    static void forEachAny(std::string_view text, std::string_view delims, F&& fn) {
+        scanAny(text, delims, [](void* ctx, size_t pos) { return static_cast<bool>((*static_cast<std::remove_reference_t<F>*>(ctx))(pos)); }, &fn);
+    }
+
+    /**
+     * @brief First occurrence of a single-byte delimiter
+     */
+    static size_t find(std::string_view text, char delim, size_t pos = 0) {
+        return findAny(text, std::string_view(&delim, 1), pos);
+    }
+
+    /**
+     * @brief First occurrence of a delimiter of any length
+     * @note Candidates are located on the first byte with the kernel, then verified
+     */
+    static size_t find(std::string_view text, std::string_view delim, size_t pos = 0);
+
+    /**
+     * @brief Call fn with every span of text between delimiters
+     * @note Empty text yields one empty span, an empty delimiter yields text itself
+     */
+    template<typename F>
+    static void forEachSpan(std::string_view text, std::string_view delim, F&& fn) {
+        if (delim.empty()) {
+            fn(text);
+            return;
+        }
+
+        size_t start = 0;
+        while (true) {
+            size_t end = find(text, delim, start);
+            if (end == std::string_view::npos) {
+                fn(text.substr(start));
+                return;
+            }
+            fn(text.substr(start, end - start));
+            start = end + delim.size();
+        }
+    }
+
+    /**
+     * @brief Append every span of text between delimiters to spans
+     */
+    static void split(std::string_view text, std::string_view delim, std::vector<std::string_view>& spans) {
+        forEachSpan(text, delim, [&spans](std::string_view span) { spans.push_back(span); });
+    }
+
+    /**
+     * @brief Same spans as split, copied into strings
+     */
+    static std::vector<std::string> splitCopy(std::string_view text, std::string_view delim) {
+        std::vector<std::string> result;
+        forEachSpan(text, delim, [&result](std::string_view span) { result.emplace_back(span); });
+        return result;
+    }
+
+private:
+    using HitFn = bool (*)(void* ctx, size_t pos);
+    static void scanAny(std::string_view text, std::string_view delims, HitFn hit, void* ctx);
+};
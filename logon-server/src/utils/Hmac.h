@@ -0,0 +1,32 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @file Hmac.h
+ * @brief SHA-256 and HMAC-SHA256 (RFC 2104) without an external crypto library.
+ */
+
+namespace Hmac {
+
+	using Digest = std::array<uint8_t, 32>;
+
+	/**
+	 * @brief SHA-256 of a byte string.
+	 */
+	Digest sha256(std::string_view data);
+
+	/**
+	 * @brief HMAC-SHA256 of data under key.
+	 */
+	Digest sign(std::string_view key, std::string_view data);
+
+	/**
+	 * @brief Compare two MACs in constant time.
+	 * @param size Amount of leading bytes compared, for truncated MACs.
+	 */
+	bool equal(const uint8_t* a, const uint8_t* b, size_t size);
+}
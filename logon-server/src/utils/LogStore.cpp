@@ -0,0 +1,444 @@
+#include "LogStore.h"
+
+#include <BaseApp.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+#include "MappedFile.h"
+#include "SnapshotIO.h"
+
+#if IS_WINDOWS
+    #include <io.h>
+#endif
+
+namespace {
+    constexpr uint32_t WAL_MAGIC = 0x4C41574C; // "LWAL"
+    constexpr uint32_t SNAPSHOT_MAGIC = 0x50534E4C; // "LNSP"
+    constexpr uint32_t FORMAT_VERSION = 1;
+    constexpr size_t WAL_HEADER_SIZE = sizeof(uint32_t) * 2;
+    constexpr size_t RECORD_HEADER_SIZE = sizeof(uint32_t) * 2;
+
+    constexpr std::array<uint32_t, 256> makeCrcTable() {
+        std::array<uint32_t, 256> table{};
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+            }
+            table[i] = crc;
+        }
+        return table;
+    }
+    constexpr std::array<uint32_t, 256> CRC_TABLE = makeCrcTable();
+
+    uint32_t crc32(const char* data, size_t size) {
+        uint32_t crc = 0xFFFFFFFFu;
+        for (size_t i = 0; i < size; i++) {
+            crc = CRC_TABLE[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    template<typename T>
+    void appendValue(std::string& out, T value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    bool syncFile(std::FILE* file) {
+        if (std::fflush(file) != 0) {
+            return false;
+        }
+#if IS_WINDOWS
+        return _commit(_fileno(file)) == 0;
+#else
+        return fsync(fileno(file)) == 0;
+#endif
+    }
+}
+
+LogStore::~LogStore() {
+    close();
+}
+
+bool LogStore::open(const std::string& dir) {
+    close();
+
+    dir_ = dir;
+    std::error_code ec;
+    std::filesystem::create_directories(dir_, ec);
+
+    std::unique_lock<std::shared_mutex> lock(stateMutex_);
+    tables_.clear();
+    replayed_ = 0;
+    loadSnapshot();
+    size_t valid = replay();
+    lock.unlock();
+
+    // Torn tail from a crash, later appends must start at a record boundary
+    std::string path = dir_ + "store.wal";
+    if (valid > WAL_HEADER_SIZE && std::filesystem::exists(path, ec) && std::filesystem::file_size(path, ec) > valid) {
+        std::filesystem::resize_file(path, valid, ec);
+    }
+    if (!openLog(valid <= WAL_HEADER_SIZE)) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> logLock(logMutex_);
+        stopping_ = false;
+        buffer_.clear();
+        appendedSeq_ = durableSeq_ = 0;
+    }
+    committer_ = std::thread(&LogStore::committer, this);
+    open_.store(true, std::memory_order_release);
+    return true;
+}
+
+void LogStore::close() {
+    if (!open_.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(logMutex_);
+        stopping_ = true;
+    }
+    logCv_.notify_all();
+    if (committer_.joinable()) {
+        committer_.join();
+    }
+
+    std::lock_guard<std::mutex> lock(logMutex_);
+    if (log_ != nullptr) {
+        std::fclose(log_);
+        log_ = nullptr;
+    }
+    durableCv_.notify_all();
+}
+
+void LogStore::put(std::string_view table, std::string_view key, std::string value) {
+    std::unique_lock<std::shared_mutex> lock(stateMutex_);
+    append(Op::Put, table, key, value);
+    apply(Op::Put, table, key, std::move(value));
+}
+
+void LogStore::erase(std::string_view table, std::string_view key) {
+    std::unique_lock<std::shared_mutex> lock(stateMutex_);
+    append(Op::Erase, table, key, {});
+    apply(Op::Erase, table, key, {});
+}
+
+std::optional<std::string> LogStore::get(std::string_view table, std::string_view key) const {
+    std::shared_lock<std::shared_mutex> lock(stateMutex_);
+    auto t = tables_.find(std::string(table));
+    if (t == tables_.end()) {
+        return std::nullopt;
+    }
+    auto it = t->second.find(std::string(key));
+    if (it == t->second.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+bool LogStore::exists(std::string_view table, std::string_view key) const {
+    std::shared_lock<std::shared_mutex> lock(stateMutex_);
+    auto t = tables_.find(std::string(table));
+    return t != tables_.end() && t->second.count(std::string(key)) > 0;
+}
+
+size_t LogStore::size(std::string_view table) const {
+    std::shared_lock<std::shared_mutex> lock(stateMutex_);
+    auto t = tables_.find(std::string(table));
+    return t != tables_.end() ? t->second.size() : 0;
+}
+
+void LogStore::forEach(std::string_view table, const std::function<void(const std::string& key, const std::string& value)>& fn) const {
+    std::shared_lock<std::shared_mutex> lock(stateMutex_);
+    auto t = tables_.find(std::string(table));
+    if (t == tables_.end()) {
+        return;
+    }
+    for (const auto& [key, value] : t->second) {
+        fn(key, value);
+    }
+}
+
+void LogStore::sync() {
+    std::unique_lock<std::mutex> lock(logMutex_);
+    uint64_t target = appendedSeq_;
+    logCv_.notify_one();
+    durableCv_.wait(lock, [&] { return durableSeq_ >= target || log_ == nullptr; });
+}
+
+bool LogStore::compact() {
+    // Same order as the committer: file, state, log
+    std::lock_guard<std::mutex> fileLock(fileMutex_);
+    std::shared_lock<std::shared_mutex> stateLock(stateMutex_);
+    std::lock_guard<std::mutex> logLock(logMutex_);
+    if (log_ == nullptr || !writeSnapshot()) {
+        return false;
+    }
+
+    // Everything buffered is part of the snapshot now
+    buffer_.clear();
+    durableSeq_ = appendedSeq_;
+    compactions_++;
+    bool reopened = openLog(true);
+    durableCv_.notify_all();
+    return reopened;
+}
+
+LogStore::Stats LogStore::getStats() const {
+    size_t records = 0;
+    {
+        std::shared_lock<std::shared_mutex> lock(stateMutex_);
+        for (const auto& [name, table] : tables_) {
+            records += table.size();
+        }
+    }
+    return { records, logBytes_.load(), commits_.load(), compactions_.load(), replayed_.load() };
+}
+
+void LogStore::apply(Op op, std::string_view table, std::string_view key, std::string value) {
+    Table& t = tables_[std::string(table)];
+    if (op == Op::Put) {
+        t[std::string(key)] = std::move(value);
+    }
+    else {
+        t.erase(std::string(key));
+    }
+}
+
+void LogStore::append(Op op, std::string_view table, std::string_view key, std::string_view value) {
+    std::string body;
+    body.reserve(sizeof(uint8_t) + sizeof(uint16_t) + table.size() + sizeof(uint32_t) * 2 + key.size() + value.size());
+    appendValue(body, static_cast<uint8_t>(op));
+    appendValue(body, static_cast<uint16_t>(table.size()));
+    body.append(table);
+    appendValue(body, static_cast<uint32_t>(key.size()));
+    body.append(key);
+    appendValue(body, static_cast<uint32_t>(value.size()));
+    body.append(value);
+
+    std::lock_guard<std::mutex> lock(logMutex_);
+    appendValue(buffer_, static_cast<uint32_t>(body.size()));
+    appendValue(buffer_, crc32(body.data(), body.size()));
+    buffer_.append(body);
+    appendedSeq_++;
+    logCv_.notify_one();
+}
+
+bool LogStore::loadSnapshot() {
+    MappedFile file;
+    if (!file.open(dir_ + "store.snap")) {
+        return false;
+    }
+
+    SnapshotReader reader(file.data(), file.size());
+    uint32_t tableCount = 0;
+    if (!reader.header(SNAPSHOT_MAGIC, FORMAT_VERSION) || !reader.read(tableCount)) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < tableCount; i++) {
+        uint16_t nameSize = 0;
+        uint32_t count = 0;
+        std::string_view name;
+        if (!reader.read(nameSize) || !reader.readBytes(name, nameSize) || !reader.read(count)) {
+            return false;
+        }
+
+        Table& table = tables_[std::string(name)];
+        table.reserve(count);
+        for (uint32_t j = 0; j < count; j++) {
+            uint32_t keySize = 0, valueSize = 0;
+            std::string_view key, value;
+            if (!reader.read(keySize) || !reader.readBytes(key, keySize) || !reader.read(valueSize) || !reader.readBytes(value, valueSize)) {
+                return false;
+            }
+            table.emplace(std::string(key), std::string(value));
+        }
+    }
+    return true;
+}
+
+size_t LogStore::replay() {
+    MappedFile file;
+    if (!file.open(dir_ + "store.wal")) {
+        return 0;
+    }
+
+    SnapshotReader header(file.data(), file.size());
+    if (!header.header(WAL_MAGIC, FORMAT_VERSION)) {
+        return 0;
+    }
+
+    const char* data = reinterpret_cast<const char*>(file.data());
+    size_t offset = WAL_HEADER_SIZE;
+    while (file.size() - offset >= RECORD_HEADER_SIZE) {
+        uint32_t size = 0, crc = 0;
+        std::memcpy(&size, data + offset, sizeof(size));
+        std::memcpy(&crc, data + offset + sizeof(size), sizeof(crc));
+        if (file.size() - offset - RECORD_HEADER_SIZE < size || crc32(data + offset + RECORD_HEADER_SIZE, size) != crc) {
+            break;
+        }
+
+        SnapshotReader reader(file.data() + offset + RECORD_HEADER_SIZE, size);
+        uint8_t op = 0;
+        uint16_t tableSize = 0;
+        uint32_t keySize = 0, valueSize = 0;
+        std::string_view table, key, value;
+        if (!reader.read(op) || !reader.read(tableSize) || !reader.readBytes(table, tableSize) || !reader.read(keySize) ||
+            !reader.readBytes(key, keySize) || !reader.read(valueSize) || !reader.readBytes(value, valueSize)) {
+            break;
+        }
+
+        apply(static_cast<Op>(op), table, key, std::string(value));
+        replayed_++;
+        offset += RECORD_HEADER_SIZE + size;
+    }
+    return offset;
+}
+
+bool LogStore::openLog(bool truncate) {
+    if (log_ != nullptr) {
+        std::fclose(log_);
+        log_ = nullptr;
+    }
+
+    std::string path = dir_ + "store.wal";
+    log_ = std::fopen(path.c_str(), truncate ? "wb" : "ab");
+    if (log_ == nullptr) {
+        return false;
+    }
+
+    if (truncate) {
+        std::string header;
+        appendValue(header, WAL_MAGIC);
+        appendValue(header, FORMAT_VERSION);
+        if (std::fwrite(header.data(), 1, header.size(), log_) != header.size() || !syncFile(log_)) {
+            return false;
+        }
+        logBytes_ = header.size();
+        return true;
+    }
+
+    std::error_code ec;
+    logBytes_ = std::filesystem::file_size(path, ec);
+    return true;
+}
+
+bool LogStore::rewindLog() {
+    if (log_ != nullptr) {
+        std::fclose(log_);
+        log_ = nullptr;
+    }
+
+    // Cut whatever a failed batch left behind the last committed record
+    std::string path = dir_ + "store.wal";
+    std::error_code ec;
+    std::filesystem::resize_file(path, logBytes_.load(), ec);
+    if (ec) {
+        return false; // log_ stays closed, nothing gets appended behind the torn bytes
+    }
+    return openLog(false);
+}
+
+bool LogStore::writeSnapshot() {
+    SnapshotWriter writer(SNAPSHOT_MAGIC, FORMAT_VERSION);
+    writer.write(static_cast<uint32_t>(tables_.size()));
+    for (const auto& [name, table] : tables_) {
+        writer.write(static_cast<uint16_t>(name.size()));
+        writer.writeBytes(name.data(), name.size());
+        writer.write(static_cast<uint32_t>(table.size()));
+        for (const auto& [key, value] : table) {
+            writer.write(static_cast<uint32_t>(key.size()));
+            writer.writeBytes(key.data(), key.size());
+            writer.write(static_cast<uint32_t>(value.size()));
+            writer.writeBytes(value.data(), value.size());
+        }
+    }
+
+    // The log is truncated right after, the snapshot has to be on disk first
+    std::string path = dir_ + "store.snap";
+    std::string temp = path + ".tmp";
+    std::FILE* file = std::fopen(temp.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    const std::string& buffer = writer.buffer();
+    bool written = std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size() && syncFile(file);
+    std::fclose(file);
+    if (!written) {
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temp, path, ec);
+    return !ec;
+}
+
+void LogStore::committer() {
+    std::unique_lock<std::mutex> lock(logMutex_);
+
+    while (true) {
+        logCv_.wait(lock, [this] { return stopping_ || !buffer_.empty(); });
+        if (buffer_.empty()) {
+            return; // Stopping with nothing left to commit
+        }
+        lock.unlock();
+
+        // Hold the file across swap and write, a compaction never sees a batch in flight
+        bool written = false;
+        bool compactDue = false;
+        {
+            std::lock_guard<std::mutex> fileLock(fileMutex_);
+            std::string batch;
+            uint64_t seq = 0;
+            {
+                std::lock_guard<std::mutex> swapLock(logMutex_);
+                batch.swap(buffer_);
+                seq = appendedSeq_;
+            }
+
+            // A compaction in between already covered the batch
+            written = batch.empty() || (log_ != nullptr &&
+                std::fwrite(batch.data(), 1, batch.size(), log_) == batch.size() && syncFile(log_));
+            if (!written) {
+                // The retry must start at a record boundary, replay stops at the first torn record
+                rewindLog();
+            }
+
+            std::lock_guard<std::mutex> doneLock(logMutex_);
+            if (written) {
+                durableSeq_ = std::max(durableSeq_, seq);
+                logBytes_ += batch.size();
+                commits_++;
+                durableCv_.notify_all();
+            }
+            else {
+                // Keep the records, retried with the next batch
+                buffer_.insert(0, batch);
+            }
+            compactDue = written && compactThreshold_ > 0 && logBytes_ >= compactThreshold_;
+        }
+
+        if (compactDue) {
+            compact();
+        }
+        lock.lock();
+
+        if (!written) {
+            if (stopping_) {
+                return; // Disk gone at shutdown, the records stay lost in memory
+            }
+            // Give the disk a moment before retrying
+            logCv_.wait_for(lock, std::chrono::milliseconds(100), [this] { return stopping_; });
+        }
+    }
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <condition_variable>
+
+/**
+ * @fileoverview LogStore - Embedded key/value store backed by a write-ahead log
+ *
+ * Records live in named tables held in memory. Every put/erase is applied in
+ * memory and appended to an in-memory log buffer; a committer thread writes
+ * the buffer to store.wal in one sequential write and syncs it once, so
+ * concurrent writers share a single fsync (group commit). sync() waits until
+ * everything appended so far is durable.
+ *
+ * Once the log grows past the compaction threshold the tables are written to
+ * store.snap (temp + rename) and the log starts over. Opening the store maps
+ * the snapshot and replays the log on top of it; a torn record at the end of
+ * the log (crash mid-write) fails its CRC and is cut off.
+ *
+ * Log record: u32 body size, u32 CRC-32 of the body, body = u8 op,
+ * u16 table size, table, u32 key size, key, u32 value size, value.
+ *
+ * @example
+ * ```cpp
+ * LogStore store;
+ * store.open("../../../database/store/");
+ * store.put("sessions", "abc", "name=...&host=...");
+ * if (auto value = store.get("sessions", "abc")) {
+ *     // *value == "name=...&host=..."
+ * }
+ * store.erase("sessions", "abc");
+ * store.close();   // Commits and syncs whatever is still buffered
+ * ```
+ */
+class LogStore {
+public:
+    enum class Op : uint8_t {
+        Put = 1,
+        Erase = 2
+    };
+
+    struct Stats {
+        size_t records;
+        uint64_t logBytes;
+        uint64_t commits;        // Group commits, one write + one sync each
+        uint64_t compactions;
+        uint64_t replayed;       // Log records applied on open
+    };
+
+    LogStore() = default;
+    ~LogStore();
+
+    LogStore(const LogStore&) = delete;
+    LogStore& operator=(const LogStore&) = delete;
+
+    /**
+     * @brief Load the snapshot, replay the log and start the committer
+     * @param dir Directory holding store.snap and store.wal, created if missing
+     * @return False if the log cannot be opened for writing
+     */
+    bool open(const std::string& dir);
+
+    /**
+     * @brief Commit everything buffered and stop the committer
+     */
+    void close();
+
+    bool isOpen() const { return open_.load(std::memory_order_acquire); }
+
+    void put(std::string_view table, std::string_view key, std::string value);
+    void erase(std::string_view table, std::string_view key);
+    std::optional<std::string> get(std::string_view table, std::string_view key) const;
+    bool exists(std::string_view table, std::string_view key) const;
+    size_t size(std::string_view table) const;
+
+    // Called under a shared lock, fn must not write to the store
+    void forEach(std::string_view table, const std::function<void(const std::string& key, const std::string& value)>& fn) const;
+
+    /**
+     * @brief Block until every record appended before the call is on disk
+     */
+    void sync();
+
+    /**
+     * @brief Write a snapshot of all tables and truncate the log
+     * @return False on I/O failure, the log is kept and still replays
+     */
+    bool compact();
+
+    // Log size that triggers compaction, 0 only compacts on demand
+    void setCompactThreshold(uint64_t bytes) { compactThreshold_ = bytes; }
+
+    Stats getStats() const;
+
+private:
+    using Table = std::unordered_map<std::string, std::string>;
+
+    // Caller holds stateMutex_ exclusively
+    void apply(Op op, std::string_view table, std::string_view key, std::string value);
+    void append(Op op, std::string_view table, std::string_view key, std::string_view value);
+
+    bool loadSnapshot();
+    size_t replay();
+    bool openLog(bool truncate);
+    // Caller holds fileMutex_
+    bool rewindLog();
+    // Caller holds stateMutex_ (shared) and logMutex_
+    bool writeSnapshot();
+    void committer();
+
+    std::string dir_;
+    std::atomic<bool> open_{ false };
+
+    mutable std::shared_mutex stateMutex_;
+    std::unordered_map<std::string, Table> tables_;
+
+    std::mutex fileMutex_;             // Owns log_ while a batch is written or the log is swapped
+    std::mutex logMutex_;
+    std::condition_variable logCv_;
+    std::condition_variable durableCv_;
+    std::string buffer_;               // Records appended but not written yet
+    uint64_t appendedSeq_ = 0;
+    uint64_t durableSeq_ = 0;
+    std::FILE* log_ = nullptr;
+    std::thread committer_;
+    bool stopping_ = false;
+
+    std::atomic<uint64_t> compactThreshold_{ 16ull * 1024 * 1024 };
+    std::atomic<uint64_t> logBytes_{ 0 };
+    std::atomic<uint64_t> commits_{ 0 };
+    std::atomic<uint64_t> compactions_{ 0 };
+    std::atomic<uint64_t> replayed_{ 0 };
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+/**
+ * @brief Lock-free multi-producer single-consumer queue (Vyukov style).
+ *
+ * push() may be called from any thread, pop() only from the single consumer.
+ * Producers never block each other: a push is one allocation and one atomic
+ * exchange.
+ *
+ * @example
+ * ```cpp
+ * MPSCQueue<int> queue;
+ * queue.push(1);        // Any thread
+ *
+ * int value;
+ * while (queue.pop(value)) {
+ *     // Consumer thread
+ * }
+ * ```
+ */
+template<typename T>
+class MPSCQueue {
+private:
+    struct Node {
+        std::atomic<Node*> next{ nullptr };
+        T value{};
+    };
+
+    alignas(64) std::atomic<Node*> head_;   ///< Last pushed node, shared by producers
+    alignas(64) Node* tail_;                ///< Stub / last consumed node, consumer only
+
+public:
+    MPSCQueue() {
+        Node* stub = new Node();
+        head_.store(stub, std::memory_order_relaxed);
+        tail_ = stub;
+    }
+
+    ~MPSCQueue() {
+        T value;
+        while (pop(value)) {}
+        delete tail_;
+    }
+
+    MPSCQueue(const MPSCQueue&) = delete;
+    MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+    /**
+     * @brief Append a value, safe from any thread
+     * @param value Value to move into the queue
+     */
+    void push(T value) {
+        Node* node = new Node();
+        node->value = std::move(value);
+
+        Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    /**
+     * @brief Take the oldest value, consumer thread only
+     * @param out Receives the value
+     * @return False if the queue is empty (or a push is not yet linked)
+     */
+    bool pop(T& out) {
+        Node* tail = tail_;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (next == nullptr) {
+            return false;
+        }
+
+        out = std::move(next->value);
+        tail_ = next;
+        delete tail;
+        return true;
+    }
+};
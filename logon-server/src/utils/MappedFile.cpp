@@ -0,0 +1,89 @@
+#include "MappedFile.h"
+
+#if !IS_WINDOWS
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+
+#if IS_WINDOWS
+    file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file_ == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file_, &fileSize) || fileSize.QuadPart == 0) {
+        close();
+        return false;
+    }
+
+    mapping_ = CreateFileMappingA(file_, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping_ == NULL) {
+        close();
+        return false;
+    }
+
+    data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    if (data_ == nullptr) {
+        close();
+        return false;
+    }
+    size_ = static_cast<size_t>(fileSize.QuadPart);
+#else
+    fd_ = ::open(path.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd_, &info) != 0 || info.st_size == 0) {
+        close();
+        return false;
+    }
+
+    void* address = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (address == MAP_FAILED) {
+        close();
+        return false;
+    }
+    data_ = static_cast<const uint8_t*>(address);
+    size_ = static_cast<size_t>(info.st_size);
+#endif
+
+    return true;
+}
+
+void MappedFile::close() {
+#if IS_WINDOWS
+    if (data_ != nullptr) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_ != NULL) {
+        CloseHandle(mapping_);
+    }
+    if (file_ != INVALID_HANDLE_VALUE) {
+        CloseHandle(file_);
+    }
+    mapping_ = NULL;
+    file_ = INVALID_HANDLE_VALUE;
+#else
+    if (data_ != nullptr) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    fd_ = -1;
+#endif
+
+    data_ = nullptr;
+    size_ = 0;
+}
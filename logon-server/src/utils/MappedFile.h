@@ -0,0 +1,57 @@
+#pragma once
+
+#include <BaseApp.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * MappedFile - Read-only memory mapping of a whole file
+ *
+ * Used to load snapshots without copying them through a stream first, the
+ * mapping is released when the object goes out of scope.
+ *
+ * @example
+ * ```cpp
+ * MappedFile file;
+ * if (file.open("cache.bin")) {
+ *     const uint8_t* data = file.data();
+ *     size_t size = file.size();
+ * }
+ * ```
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Map a file, closing any previous mapping
+     * @param path File to map
+     * @return False if the file is missing, empty or cannot be mapped
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief Unmap the file
+     */
+    void close();
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+
+#if IS_WINDOWS
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = NULL;
+#else
+    int fd_ = -1;
+#endif
+};
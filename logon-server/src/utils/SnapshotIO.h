@@ -0,0 +1,156 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <fstream>
+#include <filesystem>
+#include <system_error>
+
+/**
+ * @fileoverview SnapshotIO - Binary snapshot helpers shared by the caches
+ *
+ * A snapshot starts with a 4 byte magic and a format version, followed by
+ * records in host byte order; snapshots only travel between restarts of the
+ * same machine. Deadlines are stored as wall-clock milliseconds since epoch,
+ * so time spent offline counts against the TTL and a steady_clock deadline
+ * survives the restart.
+ *
+ * @example
+ * ```cpp
+ * SnapshotWriter writer(MAGIC, 1);
+ * writer.write<uint32_t>(42);
+ * writer.writeBytes("key", 3);
+ * writer.commit("cache.bin");
+ *
+ * MappedFile file;
+ * file.open("cache.bin");
+ * SnapshotReader reader(file.data(), file.size());
+ * uint32_t value;
+ * if (reader.header(MAGIC, 1) && reader.read(value)) {
+ *     // value == 42
+ * }
+ * ```
+ */
+
+class SnapshotWriter {
+public:
+    SnapshotWriter(uint32_t magic, uint32_t version) {
+        write(magic);
+        write(version);
+    }
+
+    template<typename T>
+    void write(const T& value) {
+        buffer_.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void writeBytes(const void* data, size_t size) {
+        buffer_.append(static_cast<const char*>(data), size);
+    }
+
+    // Overwrite a value written earlier, e.g. a record count only known at the end
+    template<typename T>
+    void patch(size_t offset, const T& value) {
+        std::memcpy(&buffer_[offset], &value, sizeof(T));
+    }
+
+    size_t offset() const { return buffer_.size(); }
+    const std::string& buffer() const { return buffer_; }
+
+    /**
+     * @brief Write the snapshot next to path and rename it over the old one
+     * @return False on I/O failure, the previous snapshot is left intact
+     */
+    bool commit(const std::string& path) const {
+        std::error_code ec;
+        std::filesystem::path target(path);
+        if (target.has_parent_path()) {
+            std::filesystem::create_directories(target.parent_path(), ec);
+        }
+
+        std::string temp = path + ".tmp";
+        {
+            std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+            if (!file.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()))) {
+                return false;
+            }
+        }
+
+        std::filesystem::rename(temp, target, ec);
+        return !ec;
+    }
+
+    // 0 for entries without TTL
+    static int64_t deadline(std::chrono::steady_clock::time_point expiresAt,
+        std::chrono::steady_clock::time_point steadyNow, std::chrono::system_clock::time_point systemNow) {
+        if (expiresAt == std::chrono::steady_clock::time_point::max()) {
+            return 0;
+        }
+        auto wallClock = systemNow + std::chrono::duration_cast<std::chrono::system_clock::duration>(expiresAt - steadyNow);
+        return std::chrono::duration_cast<std::chrono::milliseconds>(wallClock.time_since_epoch()).count();
+    }
+
+private:
+    std::string buffer_;
+};
+
+class SnapshotReader {
+public:
+    SnapshotReader(const uint8_t* data, size_t size)
+        : cursor_(data), end_(data + size) {
+    }
+
+    bool header(uint32_t magic, uint32_t version) {
+        uint32_t fileMagic = 0, fileVersion = 0;
+        return read(fileMagic) && read(fileVersion) && fileMagic == magic && fileVersion == version;
+    }
+
+    template<typename T>
+    bool read(T& value) {
+        if (static_cast<size_t>(end_ - cursor_) < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&value, cursor_, sizeof(T));
+        cursor_ += sizeof(T);
+        return true;
+    }
+
+    // The view points into the mapping, copy it before the file is closed
+    bool readBytes(std::string_view& value, size_t size) {
+        if (static_cast<size_t>(end_ - cursor_) < size) {
+            return false;
+        }
+        value = std::string_view(reinterpret_cast<const char*>(cursor_), size);
+        cursor_ += size;
+        return true;
+    }
+
+    /**
+     * @brief Convert a stored deadline back to the steady clock
+     * @param remaining Time left, only set for entries with TTL
+     * @return False if the entry already expired
+     */
+    static bool deadline(int64_t stored, std::chrono::steady_clock::time_point& expiresAt, std::chrono::milliseconds& remaining,
+        std::chrono::steady_clock::time_point steadyNow, std::chrono::system_clock::time_point systemNow) {
+        if (stored == 0) {
+            expiresAt = std::chrono::steady_clock::time_point::max();
+            remaining = std::chrono::milliseconds(0);
+            return true;
+        }
+
+        auto nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(systemNow.time_since_epoch()).count();
+        if (stored <= nowMs) {
+            return false;
+        }
+        remaining = std::chrono::milliseconds(stored - nowMs);
+        expiresAt = steadyNow + remaining;
+        return true;
+    }
+
+private:
+    const uint8_t* cursor_;
+    const uint8_t* end_;
+};
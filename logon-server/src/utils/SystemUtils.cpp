@@ -19,6 +19,7 @@
     #include <cstdlib>
     #include <sys/sysinfo.h>
     #include <unistd.h>
+    #include <pthread.h>
     
     #if IS_MAC
         #include <mach/mach.h>
@@ -267,6 +268,34 @@ void SystemUtils::sleepMs(int milliseconds) {
 #endif
 }
 
+bool SystemUtils::pinThreadToCore(std::thread& thread, size_t core) {
+    size_t cores = getCoreCount();
+    if (cores == 0 || !thread.joinable()) {
+        return false;
+    }
+    core %= cores;
+
+#if IS_WINDOWS
+    if (core >= sizeof(DWORD_PTR) * 8) {
+        return false;
+    }
+    DWORD_PTR mask = static_cast<DWORD_PTR>(1) << core;
+    return SetThreadAffinityMask(thread.native_handle(), mask) != 0;
+#elif IS_LINUX
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(core, &cpuset);
+    return pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t), &cpuset) == 0;
+#else
+    // macOS only supports affinity hints, leave scheduling to the OS
+    return false;
+#endif
+}
+
+size_t SystemUtils::getCoreCount() {
+    return std::thread::hardware_concurrency();
+}
+
 std::string SystemUtils::getOSName() {
 #if IS_WINDOWS
     return "Windows";
@@ -2,6 +2,9 @@
 
 #include <BaseApp.h>
 
+#include <string>
+#include <thread>
+
 // Struktur untuk informasi memory
 struct MemoryInfo {
     unsigned long long total_phys_mem = 0;    // bytes
@@ -36,6 +39,8 @@ public:
     
     // Utility functions
     static void sleepMs(int milliseconds);
+    static bool pinThreadToCore(std::thread& thread, size_t core);
+    static size_t getCoreCount();
     static std::string getOSName();
     static bool isWindows();
     static bool isLinux();
@@ -0,0 +1,365 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <shared_mutex>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "MappedFile.h"
+#include "SnapshotIO.h"
+
+/**
+ * @fileoverview TypedCache - Fixed-capacity cache with compile-time key/value types
+ *
+ * Open addressing (linear probing, backward-shift deletion) over one flat slot
+ * array, keys and values are stored in place. The array is sized once in the
+ * constructor, set/get never allocate and never go through a variant.
+ *
+ * Once maxEntries is reached, the entry closest to expiry within the probe
+ * window of the new key is replaced, so an expired one there goes first.
+ * set never sweeps the whole table, that is left to cleanupExpired().
+ *
+ * Tables with trivially copyable keys and values can be written to and
+ * restored from a binary snapshot, deadlines survive the restart.
+ *
+ * @example Basic Usage:
+ * ```cpp
+ * TypedCache<uint32_t, bool> addresses(65536);
+ * addresses.set(peer->address.host, true, std::chrono::seconds(300));
+ *
+ * if (addresses.exists(peer->address.host)) {
+ *     // Seen within the last 5 minutes
+ * }
+ *
+ * bool value;
+ * if (addresses.get(peer->address.host, value)) {
+ *     // Hit, value copied out
+ * }
+ * ```
+ */
+
+template<typename K, typename V, typename Hash = std::hash<K>>
+class TypedCache {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Cache statistics
+    struct Stats {
+        size_t size;
+        size_t capacity;
+        size_t hits;
+        size_t misses;
+        size_t evictions;
+    };
+
+    /**
+     * @brief Allocate the slot array up front
+     * @param maxEntries Maximum amount of live entries
+     */
+    explicit TypedCache(size_t maxEntries)
+        : maxEntries_(maxEntries ? maxEntries : 1) {
+        // Keep the load factor under 0.75 so probe runs stay short
+        size_t capacity = 8;
+        shift_ = 61;
+        while (capacity < maxEntries_ + maxEntries_ / 3 + 1) {
+            capacity <<= 1;
+            shift_--;
+        }
+        slots_.resize(capacity);
+        mask_ = capacity - 1;
+    }
+
+    /**
+     * @brief Store value, overwriting any previous one
+     * @param key The cache key
+     * @param value Value to store
+     * @param ttl Time to live, zero keeps the entry until it is removed or evicted
+     */
+    void set(const K& key, const V& value, std::chrono::seconds ttl = std::chrono::seconds(0)) {
+        auto now = Clock::now();
+        auto expiresAt = ttl.count() > 0 ? now + ttl : Clock::time_point::max();
+
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+
+        size_t index = find(key);
+        if (index != NPOS) {
+            slots_[index].value = value;
+            slots_[index].expiresAt = expiresAt;
+            return;
+        }
+
+        if (size_ >= maxEntries_) {
+            evictNear(key);
+        }
+
+        index = home(key);
+        while (slots_[index].used) {
+            index = (index + 1) & mask_;
+        }
+
+        Slot& slot = slots_[index];
+        slot.key = key;
+        slot.value = value;
+        slot.expiresAt = expiresAt;
+        slot.used = true;
+        size_++;
+    }
+
+    /**
+     * @brief Copy the value of a live entry into out
+     * @return True on hit, out is left untouched on miss
+     */
+    bool get(const K& key, V& out) const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+
+        size_t index = find(key);
+        if (index == NPOS || isExpired(slots_[index], Clock::now())) {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        out = slots_[index].value;
+        return true;
+    }
+
+    /**
+     * @brief Check if key exists and is not expired
+     */
+    bool exists(const K& key) const {
+        V value;
+        return get(key, value);
+    }
+
+    /**
+     * @brief Remove key from cache
+     * @return True if key was removed
+     */
+    bool remove(const K& key) {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+
+        size_t index = find(key);
+        if (index == NPOS) {
+            return false;
+        }
+        erase(index);
+        return true;
+    }
+
+    /**
+     * @brief Clean up expired entries
+     * @return Number of entries removed
+     * @note Walks the whole slot array, call it from a housekeeping timer
+     */
+    size_t cleanupExpired() {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        return purgeExpired(Clock::now());
+    }
+
+    /**
+     * @brief Clear all entries, the slot array is kept
+     */
+    void clear() {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        for (Slot& slot : slots_) {
+            slot = Slot();
+        }
+        size_ = 0;
+    }
+
+    /**
+     * @brief Write every live entry with its deadline to a binary snapshot
+     * @param path Snapshot file, replaced atomically
+     * @return False if the file could not be written
+     */
+    bool saveSnapshot(const std::string& path) const {
+        static_assert(std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V>,
+            "TypedCache snapshots store keys and values as raw bytes");
+
+        SnapshotWriter writer(SNAPSHOT_MAGIC, SNAPSHOT_VERSION);
+        writer.write(static_cast<uint32_t>(sizeof(K)));
+        writer.write(static_cast<uint32_t>(sizeof(V)));
+
+        auto steadyNow = Clock::now();
+        auto systemNow = std::chrono::system_clock::now();
+
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        writer.write(static_cast<uint64_t>(size_));
+        for (const Slot& slot : slots_) {
+            if (slot.used) {
+                // Expired slots are written too, the loader drops them against the wall clock
+                writer.write(slot.key);
+                writer.write(slot.value);
+                writer.write(SnapshotWriter::deadline(slot.expiresAt, steadyNow, systemNow));
+            }
+        }
+        lock.unlock();
+
+        return writer.commit(path);
+    }
+
+    /**
+     * @brief Load a snapshot written by saveSnapshot, the file is memory-mapped
+     * @param path Snapshot file
+     * @return Number of entries restored, expired ones are skipped
+     */
+    size_t loadSnapshot(const std::string& path) {
+        static_assert(std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V>,
+            "TypedCache snapshots store keys and values as raw bytes");
+
+        MappedFile file;
+        if (!file.open(path)) {
+            return 0;
+        }
+
+        SnapshotReader reader(file.data(), file.size());
+        uint32_t keySize = 0, valueSize = 0;
+        uint64_t count = 0;
+        if (!reader.header(SNAPSHOT_MAGIC, SNAPSHOT_VERSION) || !reader.read(keySize) || !reader.read(valueSize)
+            || keySize != sizeof(K) || valueSize != sizeof(V) || !reader.read(count)) {
+            return 0;
+        }
+
+        auto steadyNow = Clock::now();
+        auto systemNow = std::chrono::system_clock::now();
+        size_t loaded = 0;
+
+        for (uint64_t i = 0; i < count; i++) {
+            K key;
+            V value;
+            int64_t deadline = 0;
+            if (!reader.read(key) || !reader.read(value) || !reader.read(deadline)) {
+                break; // Truncated snapshot, keep what was restored so far
+            }
+
+            Clock::time_point expiresAt;
+            std::chrono::milliseconds remaining;
+            if (!SnapshotReader::deadline(deadline, expiresAt, remaining, steadyNow, systemNow)) {
+                continue;
+            }
+
+            set(key, value, std::chrono::seconds(0));
+            setDeadline(key, expiresAt);
+            loaded++;
+        }
+        return loaded;
+    }
+
+    /**
+     * @brief Get cache statistics
+     */
+    Stats getStats() const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return Stats{
+            size_,
+            slots_.size(),
+            hits_.load(std::memory_order_relaxed),
+            misses_.load(std::memory_order_relaxed),
+            evictions_
+        };
+    }
+
+private:
+    struct Slot {
+        K key{};
+        V value{};
+        Clock::time_point expiresAt{};
+        bool used = false;
+    };
+
+    static constexpr size_t NPOS = static_cast<size_t>(-1);
+    static constexpr size_t PROBE_WINDOW = 16;
+    static constexpr uint32_t SNAPSHOT_MAGIC = 0x43544747;     // "GGTC"
+    static constexpr uint32_t SNAPSHOT_VERSION = 1;
+
+    std::vector<Slot> slots_;
+    size_t mask_ = 0;
+    unsigned shift_ = 0;
+    size_t size_ = 0;
+    size_t maxEntries_;
+    size_t evictions_ = 0;
+    mutable std::atomic<size_t> hits_{ 0 };
+    mutable std::atomic<size_t> misses_{ 0 };
+    mutable std::shared_mutex mutex_;
+
+    // Fibonacci hashing, std::hash of integers is the identity on common implementations
+    size_t home(const K& key) const {
+        uint64_t hash = static_cast<uint64_t>(Hash{}(key)) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(hash >> shift_);
+    }
+
+    void setDeadline(const K& key, Clock::time_point expiresAt) {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        size_t index = find(key);
+        if (index != NPOS) {
+            slots_[index].expiresAt = expiresAt;
+        }
+    }
+
+    static bool isExpired(const Slot& slot, Clock::time_point now) {
+        return now >= slot.expiresAt;
+    }
+
+    size_t find(const K& key) const {
+        size_t index = home(key);
+        while (slots_[index].used) {
+            if (slots_[index].key == key) {
+                return index;
+            }
+            index = (index + 1) & mask_;
+        }
+        return NPOS;
+    }
+
+    // Backward-shift deletion, keeps every probe run contiguous without tombstones
+    void erase(size_t index) {
+        size_t next = (index + 1) & mask_;
+        while (slots_[next].used) {
+            size_t ideal = home(slots_[next].key);
+            // Move next into the hole unless its home lies cyclically in (index, next]
+            if (((next - ideal) & mask_) >= ((next - index) & mask_)) {
+                slots_[index] = std::move(slots_[next]);
+                index = next;
+            }
+            next = (next + 1) & mask_;
+        }
+        slots_[index] = Slot();
+        size_--;
+    }
+
+    size_t purgeExpired(Clock::time_point now) {
+        size_t removedCount = 0;
+        for (size_t index = 0; index < slots_.size();) {
+            // erase shifts the following slot into index, look at it again
+            if (slots_[index].used && isExpired(slots_[index], now)) {
+                erase(index);
+                removedCount++;
+            }
+            else {
+                index++;
+            }
+        }
+        return removedCount;
+    }
+
+    void evictNear(const K& key) {
+        size_t index = home(key);
+        size_t victim = NPOS;
+        // Past the window only until a victim turns up, the table holds at least one entry here
+        for (size_t i = 0; i < PROBE_WINDOW || victim == NPOS; i++, index = (index + 1) & mask_) {
+            if (!slots_[index].used) {
+                continue;
+            }
+            if (victim == NPOS || slots_[index].expiresAt < slots_[victim].expiresAt) {
+                victim = index;
+            }
+        }
+
+        erase(victim);
+        evictions_++;
+    }
+};
@@ -5,10 +5,15 @@
 #include <SDK/Builders/WorldOffersBuilder.h>
 #include "ColorConverter.h"
 #include "FileSystem2.h"
+#include "DelimiterScanner.h"
 #include <regex>
 #include <SDK/Builders/DialogBuilder.h>
 #include "VariantList.h"
 #include <GlobalVar.h>
+#include <server/DataManager.h>
+#include <server/HandlerPool.h>
+#include <server/MerchantCatalog.h>
+#include <server/RegistrationIndex.h>
 
 GameDialog Utils::DialogJoinMerchant(const std::string& name, const std::string& tankIDName, const std::string& tankIDPass, const std::string& message) {
   GameDialog ctx;
@@ -136,30 +141,36 @@ bool Utils::containsPathTraversal(const std::string& text) {
   return false;
 }
 bool Utils::PeerValidation(ENetPeer* peer) {
+  // On a handler worker the peer belongs to the service thread, only the context may be checked
+  if (HandlerContext* ctx = HandlerContext::current())
+    return ctx->peer == peer && !ctx->disconnect && !ctx->player->is_disconnecting();
+
   return !(!peer || peer == nullptr || !peer->data || peer->data == NULL || peer->state != ENET_PEER_STATE_CONNECTED);
 }
 void Utils::disconnect_peer(ENetPeer* peer) {
-  enet_peer_disconnect_later(peer, 0);
+  if (!PeerValidation(peer))
+    return;
+
+  // Queued behind the packets already sent, the shard applies it in order
+  pClient->set_disconnecting(true);
+  pClient->get_handle().disconnect();
+
+  if (HandlerContext* ctx = HandlerContext::current()) {
+    ctx->disconnect = true;
+    return;
+  }
+  release_peer_data(peer);
+}
+void Utils::release_peer_data(ENetPeer* peer) {
   if (peer->data != NULL) {
-    delete peer->data;
+    // Handlers of this player may still be queued, delete it after them
+    HandlerPool::retire(static_cast<Player*>(peer->data));
     peer->data = NULL;
   }
 }
 std::vector<std::string> Utils::split(const std::string& delimiter, const std::string& str) {
-	std::vector<std::string> result;
-	size_t start = 0;
-	size_t end = str.find(delimiter);
-
-	while (end != std::string::npos) {
-		result.push_back(str.substr(start, end - start));
-		start = end + delimiter.length();
-		end = str.find(delimiter, start);
-	}
-
-	// Tambahkan substring terakhir
-	result.push_back(str.substr(start));
-
-	return result;
+	// Substring terakhir selalu ikut, juga saat str kosong
+	return DelimiterScanner::splitCopy(str, delimiter);
 }
 std::string Utils::format_number(long long int number, bool add_comma, int max_digits) {
 	std::string result;
@@ -182,26 +193,26 @@ std::string Utils::format_number(long long int number, bool add_comma, int max_d
 	}
 	return result;
 }
-void Utils::merchant_profile(ENetPeer* peer, nlohmann::json& tData) {
-  auto& mData = tData["merchant"];
-  auto& sData = tData["servers"];
+void Utils::merchant_profile(ENetPeer* peer, const Merchant& merchant, const ServerList* servers) {
   GameDialog ctx;
   int activeServer = 0;
 
-  for (auto& server : sData["servers"]) {
-    if (server["options"]["disable"].get<bool>())
-      continue;
-    
-    activeServer++;
+  if (servers != nullptr) {
+    for (const auto& server : servers->servers) {
+      if (server.disable)
+        continue;
+
+      activeServer++;
+    }
   }
 
   ctx.SetDefaultColor('o')
-  ->AddLabel(eDialogElementSizes::BIG, fmt::format("`w{} Profile", mData["name"].get<std::string>()), eDialogElementDirections::LEFT)
-  ->EmbedData("merchant", mData.dump())
+  ->AddLabel(eDialogElementSizes::BIG, fmt::format("`w{} Profile", merchant.name), eDialogElementDirections::LEFT)
+  ->EmbedData("merchant", merchant.to_json().dump())
   ->AddSmallText("This is where you'll see your profile and keep an eye on the stats of all your servers.")
   ->AddSpacer(eDialogElementSizes::SMALL)
-  ->AddTextbox(fmt::format("Coin: `6{}", Utils::format_number(mData["coin"].get<int>())))
-  ->AddTextbox(fmt::format("Server registered: `2{}", Utils::format_number(mData["coin"].get<int>())))
+  ->AddTextbox(fmt::format("Coin: `6{}", Utils::format_number(merchant.coin)))
+  ->AddTextbox(fmt::format("Server registered: `2{}", Utils::format_number(merchant.coin)))
   ->AddTextbox(fmt::format("Active servers: `2{}", Utils::format_number(activeServer)))
   ->AddSpacer(eDialogElementSizes::SMALL)
   ->AddButton("topup_coin", "Topup coin")
@@ -215,7 +226,6 @@ void Utils::merchant_profile(ENetPeer* peer, nlohmann::json& tData) {
 std::string Utils::generate_world_offers(Player* player) {
   uint32_t default_color = ColorConverter::toBGRA(214,171,94,255);
   std::string merchant = player->tData["ltoken"]["merchant_name"].get<std::string>();
-  std::string base_path = "../../../database/";
   std::string additional_msg = "";
   RoleManager pRole = player->get_roles();
   PlayerCredentials pCredentials = player->get_credentials();
@@ -224,20 +234,18 @@ std::string Utils::generate_world_offers(Player* player) {
   int mCoin = 0;
 
   // Fetch merchant data
-  if (!std::filesystem::exists(base_path + "merchants/" + merchant + ".json")) 
+  std::shared_ptr<const MerchantCatalog::Snapshot> catalog = MerchantCatalog::acquire(merchant);
+  const Merchant* mData = catalog->find_merchant(merchant);
+  if (mData == nullptr)
     throw std::runtime_error(fmt::format("This merchant ({}) are not affiliated with us!", merchant));
 
-  player->tData["merchant"] = FileSystem2::readJson(base_path + "merchants/" + merchant + ".json");
-  auto& mData = player->tData["merchant"];
-
-  if (pCredentials.tankIDName == mData["tankIDName"].get<std::string>() && pCredentials.tankIDPass == mData["tankIDPass"].get<std::string>()) {
-    mCoin = mData["coin"].get<int>();
+  if (pCredentials.tankIDName == mData->tankIDName && pCredentials.tankIDPass == mData->tankIDPass) {
+    mCoin = mData->coin;
 
     // Set role
-    std::string tRole = mData["role"].get<std::string>();
-    if (tRole == "admin")
+    if (mData->role == "admin")
       pRole.add_role(PlayerRole::ADMIN);
-    else if (tRole == "merchant")
+    else if (mData->role == "merchant")
       pRole.add_role(PlayerRole::MERCHANT);
     player->set_roles(pRole);
 
@@ -245,7 +253,7 @@ std::string Utils::generate_world_offers(Player* player) {
     if (mCoin < 1) {
       additional_msg = "`9Warning`w: Your total coins are now `o0`w, don't forget to top up in `5Dashboard -> My profile -> Top up coins`w.";
     }
-    hide_servers = mData["options"]["hide_servers"].get<bool>();
+    hide_servers = mData->hide_servers;
   }
 
   // testing only
@@ -256,56 +264,48 @@ std::string Utils::generate_world_offers(Player* player) {
   int tPage = 0;
   int req_page = (tData.contains("page") ? tData["page"].get<int>() : 0);
   int max_servers_page = 10;
-  std::map<int, std::vector<nlohmann::json>> pagination = {};
-
-  // Fetch servers is exists
-  if (std::filesystem::exists(base_path + "servers/" + mData["servers_key"].get<std::string>() + ".json"))  {
-    player->tData["servers"] = FileSystem2::readJson(base_path + "servers/" + mData["servers_key"].get<std::string>() + ".json");
-    auto& sData = player->tData["servers"];
-
-    if (sData.contains("servers") && sData["servers"].is_array()) {
-      auto& servers = sData["servers"];
-      
-      int i = 0, disabled = 0;
-      for (auto& server : servers) {
-        // Check if expired 
-        if (server["options"]["disable"].get<bool>())
-          continue;
-          
-        TimePoint expired_at = std::chrono::steady_clock::time_point(std::chrono::seconds(server["expired_at"].get<long long>()));
-        if (expired_at < current_time()) {
-          // Perpanjang durasi
-          if (mCoin > 0) {
-            mCoin--;
-            expired_at = current_time() + std::chrono::days(30);
-            server["expired_at"] = std::chrono::duration_cast<std::chrono::seconds>(expired_at.time_since_epoch()).count();
-            mData["coin"] = mCoin;
-          }
-          else {
-            server["options"]["disable"] = true;
-            disabled++;
-          }
-        }
-      
-        if (!mData["options"]["hide_servers"].get<bool>() && !server["options"]["hide_server"].get<bool>()) {
-          if (i >= max_servers_page) {
-            max_servers_page *= 2;
-            tPage++;
-          }
-          
-          pagination[tPage].emplace_back(server);
-        }
-
-        i++;
+  std::map<int, std::vector<const MerchantServer*>> pagination = {};
+
+  // Expired servers are renewed (or disabled) by the catalog writer, the common case only reads.
+  // Renewal spends the owner's coins whoever opens the list, not only when the owner logs in
+  const ServerList* sData = catalog->find_servers(mData->servers_key);
+  TimePoint now = current_time();
+  if (sData != nullptr && std::any_of(sData->servers.begin(), sData->servers.end(), [&](const MerchantServer& server) { return !server.disable && server.expired(now); })) {
+    int disabled = 0;
+    MerchantCatalog::update(merchant, [&](Merchant& owner, ServerList& servers) {
+      disabled = 0;
+      for (auto& server : servers.servers) {
+        if (!server.disable && !server.renew(owner, now))
+          disabled++;
       }
+      return true;
+    });
 
-      if (disabled) {
-        additional_msg += fmt::format("`w[`4{} servers have been disabled due to insufficient coins!`w]", disabled);
-      }
+    if (disabled) {
+      additional_msg += fmt::format("`w[`4{} servers have been disabled due to insufficient coins!`w]", disabled);
     }
+    catalog = MerchantCatalog::snapshot();
+    mData = catalog->find_merchant(merchant);
+    sData = catalog->find_servers(mData->servers_key);
+  }
+
+  if (sData != nullptr) {
+    int i = 0;
+    for (const auto& server : sData->servers) {
+      if (server.disable)
+        continue;
+
+      if (!mData->hide_servers && !server.hide_server) {
+        if (i >= max_servers_page) {
+          max_servers_page *= 2;
+          tPage++;
+        }
+        
+        pagination[tPage].emplace_back(&server);
+      }
 
-    FileSystem2::writeJson(base_path + "servers/" + mData["servers_key"].get<std::string>() + ".json", sData);
-    FileSystem2::writeJson(base_path + "merchants/" + merchant + ".json", mData);
+      i++;
+    }
   }
 
   // Build world offers
@@ -320,29 +320,16 @@ std::string Utils::generate_world_offers(Player* player) {
     ctx.AddButton("My Profile", "my_profile", 0.5, default_color)->AddButton("Add new server", "add_new_server", 0.5, default_color);
   }
   else {
-    nlohmann::json reg = FileSystem2::readJson(databaseDir + "registered.json");
-    std::vector<std::string> regs = {};
-
-    if (reg.contains(pCredentials.IPv4))
-      regs = reg[pCredentials.IPv4].get<std::vector<std::string>>();
-
-    if (regs.size() <= 2)
+    if (RegistrationIndex::count(pCredentials.address) < RegistrationIndex::MAX_PER_ADDRESS)
       ctx.AddButton("Join merchant", "join_merchant", 0.5, default_color);
   }
 
   if (pagination.size()) {
     ctx.AddHeading("Available servers<CR>");
-    for (const auto& a : pagination[req_page]) {
-      std::string display_name = a.value("display_name", "NONE");
-      std::string name = a.value("name", "NONE");
-      std::string host = a.value("host", "127.0.0.1");
-      int port = a.value("port", 17091);
-      nlohmann::json opts = a.value("options", nlohmann::json());
-      bool block_3rd_app = opts.value("block_3rd_app", false);
-      nlohmann::json color = opts.value("color", nlohmann::json());
-      uint32_t buttonColor = ColorConverter::toBGRA(color.value("blue", 0), color.value("green", 0), color.value("red", 0), color.value("alpha", 0));
-
-      ctx.AddButton(display_name, fmt::format("name={}&host={}&port={}&block_3rd_app={}", name, host, port, block_3rd_app), 0.6, buttonColor);
+    for (const MerchantServer* a : pagination[req_page]) {
+      uint32_t buttonColor = ColorConverter::toBGRA(a->color.blue, a->color.green, a->color.red, a->color.alpha);
+
+      ctx.AddButton(a->display_name, fmt::format("name={}&host={}&port={}&block_3rd_app={}", a->name, a->host, a->port, a->block_3rd_app), 0.6, buttonColor);
     }
 
     // ctx.AddHeading("`oPage `1" + std::to_string(req_page + 1) + " ``of `1" + std::to_string(pagination.size()) + "<CR>");
@@ -462,6 +449,12 @@ std::string Utils::base64_encode(unsigned char const* bytes_to_encode, unsigned
 bool Utils::is_base64(unsigned char c) {
   return (isalnum(c) || (c == '+') || (c == '/'));
 }
+void Utils::SendConstPacket(ENetPeer* peer, ConstPacketId id) {
+  if (!PeerValidation(peer))
+    return;
+
+  pClient->get_handle().send(id);
+}
 void Utils::SendPacket(ENetPeer* peer, const int& num, char* data, const int& len) {
   if (!PeerValidation(peer))
     return;
@@ -473,7 +466,7 @@ void Utils::SendPacket(ENetPeer* peer, const int& num, char* data, const int& le
   }
   char zero = 0;
   memcpy ( packet->data + 2 + len , &zero , 1 );
-  enet_peer_send ( peer , 0 , packet ); return;
+  pClient->get_handle ( ).send ( packet ); return;
 
   if ( len >= 5 ) {
     packet->data[ 2 ] = 0xAA;
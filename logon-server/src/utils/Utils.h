@@ -6,7 +6,10 @@
 
 #include <enet/enet.h>
 
+#include <packet/ConstPacket.h>
+
 #include <player/Player.h>
+#include <server/MerchantCatalog.h>
 #include <SDK/Builders/DialogBuilder.h>
 
 inline const std::string base64_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
@@ -16,19 +19,23 @@ inline const std::string base64_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
 namespace Utils {
   bool PeerValidation(ENetPeer* peer);
   void SendPacket(ENetPeer* peer, const int& num, char* data, const int& len);
+  // Queue a pre-encoded packet, see ConstPacketSet
+  void SendConstPacket(ENetPeer* peer, ConstPacketId id);
   bool is_base64(unsigned char c);
   std::string base64_encode(unsigned char const* bytes_to_encode, unsigned int in_len);
   std::string base64_decode(std::string const& encoded_string);
   std::string param_get_value(const std::string& key, const std::string& data);
   std::string generate_world_offers(Player* player);
   void disconnect_peer(ENetPeer* peer);
+  // Detach player dari peer, dihapus setelah semua handler-nya selesai
+  void release_peer_data(ENetPeer* peer);
   std::vector<std::string> split(const std::string& delimiter, const std::string& str);
   // Fungsi untuk memeriksa apakah GUID valid
   bool isValidGUID ( const std::string& guid );
   // Fungsi untuk memeriksa apakah alamat MAC valid
   bool isValidMACAddress ( const std::string& mac );
   std::string format_number(long long int number, bool add_comma = true, int max_digits = 0);
-  void merchant_profile(ENetPeer* peer, nlohmann::json& tData);
+  void merchant_profile(ENetPeer* peer, const Merchant& merchant, const ServerList* servers);
   // Validasi text untuk path safety
   bool isPathSafeText(const std::string& text);
   // Bersihkan text dari karakter tidak diizinkan
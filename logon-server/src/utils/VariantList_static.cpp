@@ -2,27 +2,32 @@
 
 #include <packet/PacketVariant.h>
 
+// Validate before building, a dropped peer costs no allocation
+template<typename... Args>
+static void send_variant(ENetPeer* peer, const Args&... args) {
+  if (!Utils::PeerValidation(peer))
+    return;
+
+  ENetPacket* packet = make_variant_packet(args...);
+  if (packet != nullptr)
+    pClient->get_handle().send(packet);
+}
+
 void VariantList::OnConsoleMessage(ENetPeer* peer, const std::string& msg, int delay) {
-  PacketVariant pkt(delay);
-  pkt.Insert("OnConsoleMessage")->Insert(msg)->CreatePacket(peer);
+  send_variant(peer, VariantOptions{ delay }, "OnConsoleMessage", msg);
 }
 void VariantList::OnDialogRequest(ENetPeer* peer, const std::string& msg, int delay) {
-  PacketVariant pkt(delay);
-  pkt.Insert("OnDialogRequest")->Insert(msg)->CreatePacket(peer);
+  send_variant(peer, VariantOptions{ delay }, "OnDialogRequest", msg);
 }
 void VariantList::SetHasGrowID(ENetPeer* peer, const bool& is_guest, const std::string& tankIDName, const std::string& tankIDPass) {
-  PacketVariant pkt;
-  pkt.Insert("SetHasGrowID")->Insert((is_guest ? 0 : 1))->Insert(tankIDName)->Insert(tankIDPass)->CreatePacket(peer);
+  send_variant(peer, "SetHasGrowID", (is_guest ? 0 : 1), tankIDName, tankIDPass);
 }
 void VariantList::OnSendToServer(ENetPeer* peer, const int& port, const std::string& host, LoginMode mode, const std::string& session, const std::string& display_name, const std::string doorID, const std::string auth_data) {
-  PacketVariant pkt;
-  pkt.Insert("OnSendToServer")->Insert(port)->Insert(session)->Insert(peer->connectID)->Insert(host + "|" + doorID + "|" + auth_data)->Insert(static_cast<int>(mode))->Insert(display_name)->CreatePacket(peer);
+  send_variant(peer, "OnSendToServer", port, session, peer->connectID, variant_concat(host, "|", doorID, "|", auth_data), static_cast<int>(mode), display_name);
 }
 void VariantList::OnRequestWorldSelectMenu(ENetPeer* peer, const std::string& ctx) {
-  PacketVariant pkt;
-  pkt.Insert("OnRequestWorldSelectMenu")->Insert(ctx)->CreatePacket(peer);
+  send_variant(peer, "OnRequestWorldSelectMenu", ctx);
 }
 void VariantList::OnFailedToEnterWorld(ENetPeer* peer) {
-  PacketVariant pkt;
-  pkt.Insert("OnFailedToEnterWorld")->CreatePacket(peer);
-}
\ No newline at end of file
+  Utils::SendConstPacket(peer, ConstPacketId::FAILED_TO_ENTER_WORLD);
+}